@@ -0,0 +1,79 @@
+/*
+ * bitdelta - checksum of the bitmap delta format of bitdiff and bitpatch
+ *
+ * The checksum of a version of a bitmap file is described in bitdelta.h.
+ *
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "bitdelta.h"
+
+
+/*
+ * delta_sum - add octets of a version of a bitmap file to its checksum
+ *
+ * given:
+ *	sum	checksum of the earlier octets, DELTA_SUM_INIT ==> none
+ *	buf	next octets of the version
+ *	len	octets in buf, a multiple of DELTA_WORD but for the last octets
+ *
+ * returns:
+ *	checksum of the earlier octets and those of buf
+ */
+unsigned long long
+delta_sum(unsigned long long sum, const u_int8_t *buf, unsigned long len)
+{
+    uint64_t word;		/* word being added */
+    unsigned long off;		/* octet offset of word */
+    unsigned long j;
+
+    for (off = 0; off < len; off += DELTA_WORD) {
+	if (len - off >= DELTA_WORD) {
+	    memcpy(&word, buf+off, DELTA_WORD);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	    word = __builtin_bswap64(word);
+#endif
+	} else {
+	    /* last word is partial */
+	    word = 0;
+	    for (j=len; j > off; --j) {
+		word = (word << 8) | buf[j-1];
+	    }
+	}
+	sum = (sum ^ word) * DELTA_SUM_MULT;
+	sum ^= sum >> 29;
+    }
+    return sum;
+}
@@ -0,0 +1,93 @@
+/*
+ * bitdelta - bitmap delta format of bitdiff and bitpatch
+ *
+ * A delta holds the changes that turn an old version of a bitmap file
+ * into a new version.  The two versions are compared a DELTA_WORD octet
+ * word at a time, and only the words that differ are recorded, as the
+ * XOR of the old and new words.  Only the octets within the length of
+ * the new version are compared, and octets beyond the end of the old
+ * version are taken to be 0.  A delta is:
+ *
+ *	header:	DELTA_MAGIC_LEN octets of DELTA_MAGIC
+ *		8 octets: length of the old version, little-endian
+ *		8 octets: length of the new version, little-endian
+ *		8 octets: checksum of the old version, little-endian
+ *		8 octets: checksum of the new version, little-endian
+ *
+ *	record:	varint: words skipped since the end of the previous record
+ *		varint: words in this record, > 0
+ *		8 octets per word: XOR of the old and new words
+ *
+ *	end:	varint: 0
+ *		varint: 0
+ *
+ * The first record skips from word 0.  The octets of the last word of
+ * the new version that lie beyond its length are 0 in the XOR.  A
+ * varint is an unsigned integer written 7 bits per octet, least
+ * significant first, with the 0x80 bit set in every octet but the last.
+ *
+ * A checksum is computed by delta_sum() over the octets of a version,
+ * a little-endian DELTA_WORD octet word at a time, with the last word
+ * padded with 0 octets.  Starting from DELTA_SUM_INIT, each word is
+ * XORed into the sum, which is then multiplied by DELTA_SUM_MULT and
+ * XORed with itself shifted right 29 bits.  It guards against applying
+ * a delta to the wrong version, not against a deliberate forgery.
+ *
+ * To apply a delta, the checksum of the bitmap is checked against that
+ * of the old version, each recorded word is XORed into the old version,
+ * the result is truncated to the length of the new version, and its
+ * checksum is checked against that of the new version.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#if !defined(INCLUDE_BITDELTA_H)
+#define INCLUDE_BITDELTA_H
+
+
+/*
+ * delta layout
+ */
+#define DELTA_MAGIC "bitdelta"		/* first octets of a delta */
+#define DELTA_MAGIC_LEN (8)		/* octets of DELTA_MAGIC */
+#define DELTA_HEADER_LEN (DELTA_MAGIC_LEN + 4*8)	/* octets of the header */
+#define DELTA_WORD (8)			/* octets per compared word */
+#define DELTA_VARINT_MAX (10)		/* max octets of a 64 bit varint */
+#define DELTA_SUM_INIT (0x6a09e667f3bcc908ULL)	/* checksum of no octets */
+#define DELTA_SUM_MULT (0x9e3779b97f4a7c15ULL)	/* checksum multiplier */
+
+
+/*
+ * external functions
+ */
+extern unsigned long long delta_sum(unsigned long long sum,
+				    const u_int8_t *buf, unsigned long len);
+
+
+#endif /* INCLUDE_BITDELTA_H */
@@ -0,0 +1,490 @@
+/*
+ * bitdiff - write the delta between two versions of a bitmap file
+ *
+ * We will compare an old and a new version of a bitmap file and write
+ * a delta on stdout that bitpatch can apply to the old version to turn
+ * it into the new version.  The delta format is described in
+ * bitdelta.h: the two versions are XORed a 64 bit word at a time, and
+ * only the words that differ are written, as runs of changed words
+ * with the count of unchanged words skipped before each run.  When the
+ * two versions differ in a few places, the delta is a small fraction of
+ * the size of the bitmap.
+ *
+ * Both versions are read a buffer at a time, so neither has to fit in
+ * memory.  Both must be regular files, as their lengths and checksums
+ * are written at the start of the delta: each is read once to find its
+ * checksum, then again to compare them.  bitpatch uses the checksums
+ * to refuse a delta made from a different old version of the same
+ * length, such as a delta that was already applied.
+ *
+ * With -s, counters of octets read, words changed, records and octets
+ * written, along with the wall clock and CPU time spent reading and
+ * comparing, are written as JSON on stderr at exit.  The same report is
+ * written when SIGUSR1 is received.
+ *
+ * With -p, the CPU cycles, instructions, branch-misses and last level
+ * cache misses of the main loop, along with cycles per octet read and
+ * instructions per cycle, are written as JSON on stderr at exit.  This
+ * requires Linux hardware performance counters.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/errno.h>
+#include <sys/stat.h>
+
+#include "stats.h"
+#include "perfctr.h"
+#include "bitdelta.h"
+
+
+/*
+ * official version
+ */
+#define VERSION "1.0.0 2026-10-19"          /* format: major.minor YYYY-MM-DD */
+
+
+/*
+ * useful defines
+ */
+#define CHUNK (65536)	/* octets compared per buffer, multiple of DELTA_WORD */
+
+
+/*
+ * usage message
+ */
+static const char * const usage =
+  "usage: %s [-h] [-V] [-s] [-p] old new\n"
+        "\n"
+        "    -h            print help message and exit\n"
+        "    -V            print version string and exit\n"
+        "    -s            write stats as JSON on stderr at exit and on SIGUSR1\n"
+        "    -p            write hardware counters of the main loop as JSON on stderr\n"
+        "\n"
+        "    old           old version of the bitmap file\n"
+        "    new           new version of the bitmap file\n"
+        "\n"
+        "    The delta from old to new is written on stdout, with the\n"
+        "    checksums of both versions that bitpatch checks\n"
+        "\n"
+        "Exit codes:\n"
+        "    0         all OK\n"
+        "    2         -h and help string printed or -V and version string printed\n"
+        "    3         command line error\n"
+        "    4         cannot open old or new, or not a regular file\n"
+        "    6         read error\n"
+        "    7         write error\n"
+        " >= 10        internal error\n"
+        "\n"
+        "%s version: %s\n";
+
+
+/*
+ * static declarations
+ */
+static char *program = NULL;    /* our name */
+static char *prog = NULL;       /* basename of program */
+static const char * const version = VERSION;
+
+/*
+ * read buffers, one word per element
+ */
+static u_int64_t oldbuf[CHUNK / DELTA_WORD];	/* old version */
+static u_int64_t newbuf[CHUNK / DELTA_WORD];	/* new version, then the XOR */
+
+/*
+ * stats counters and phases, see -s
+ */
+static unsigned long long octets_read = 0;	/* octets of both versions read */
+static unsigned long long words_changed = 0;	/* words that differ */
+static unsigned long long records_written = 0;	/* runs of changed words written */
+static unsigned long long octets_written = 0;	/* octets of delta written */
+
+
+/*
+ * static functions
+ */
+static FILE *open_version(const char *filename, unsigned long long *len);
+static unsigned long long sum_version(FILE *stream, const char *filename,
+				      unsigned long long len);
+static void read_version(FILE *stream, const char *filename,
+			 u_int64_t *buf, unsigned long len);
+static void put_u64(unsigned long long value);
+static void put_varint(unsigned long long value);
+
+
+int
+main(int argc, char *argv[])
+{
+    FILE *oldf;			/* old version */
+    FILE *newf;			/* new version */
+    unsigned long long oldlen;	/* octets in the old version */
+    unsigned long long newlen;	/* octets in the new version */
+    unsigned long long oldsum;	/* checksum of the old version */
+    unsigned long long newsum;	/* checksum of the new version */
+    unsigned long long pos;	/* octet offset of the buffer */
+    unsigned long long skip;	/* unchanged words since the last record */
+    unsigned long len;		/* octets of the new version in the buffer */
+    unsigned long oldcnt;	/* octets of the old version in the buffer */
+    unsigned long nwords;	/* words in the buffer */
+    unsigned long w;		/* word in the buffer */
+    unsigned long run;		/* first word of a run of changed words */
+    int read_phase;		/* reading the versions */
+    int diff_phase;		/* comparing and writing the delta */
+    int i;
+
+    /*
+     * parse args
+     */
+    program = argv[0];
+    prog = rindex(program, '/');
+    if (prog == NULL) {
+        prog = program;
+    } else {
+        ++prog;
+    }
+    while ((i = getopt(argc, argv, ":hVsp")) != -1) {
+	switch (i) {
+
+        case 'h':                   /* -h - print help message and exit */
+	    fprintf(stderr, usage, program, prog, version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 'V':                   /* -V - print version string and exit */
+            (void) printf("%s\n", version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 's':                   /* -s - write stats */
+	    stats_setup(prog);
+	    break;
+
+	case 'p':                   /* -p - write hardware counters */
+	    perfctr_setup(prog);
+	    break;
+
+	case ':':
+            (void) fprintf(stderr, "%s: ERROR: requires an argument -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        case '?':
+            (void) fprintf(stderr, "%s: ERROR: illegal option -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        default:
+            fprintf(stderr, "%s: ERROR: invalid -flag\n", program);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+        }
+    }
+    /* skip over command line options */
+    argv += optind;
+    argc -= optind;
+    /* check the arg count */
+    if (argc != 2) {
+        fprintf(stderr, "%s: ERROR: expected 2 args, found: %d\n", program, argc);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+
+    /*
+     * setup and initialize
+     */
+    oldf = open_version(argv[0], &oldlen);
+    newf = open_version(argv[1], &newlen);
+    stats_counter("octets_read", &octets_read);
+    stats_counter("words_changed", &words_changed);
+    stats_counter("records_written", &records_written);
+    stats_counter("octets_written", &octets_written);
+    read_phase = stats_phase("read");
+    diff_phase = stats_phase("diff");
+    perfctr_start();
+
+    /*
+     * find the checksum of each version
+     */
+    stats_switch(read_phase);
+    oldsum = sum_version(oldf, argv[0], oldlen);
+    newsum = sum_version(newf, argv[1], newlen);
+    stats_bytes(read_phase, oldlen + newlen);
+
+    /*
+     * write the header
+     */
+    clearerr(stdout);
+    fwrite(DELTA_MAGIC, 1, DELTA_MAGIC_LEN, stdout);
+    octets_written += DELTA_MAGIC_LEN;
+    put_u64(oldlen);
+    put_u64(newlen);
+    put_u64(oldsum);
+    put_u64(newsum);
+
+    /*
+     * compare a buffer at a time
+     *
+     * A run of changed words that continues into the next buffer is
+     * written as two records, the second skipping 0 words.
+     */
+    skip = 0;
+    for (pos = 0; pos < newlen; pos += len) {
+
+	/*
+	 * read a buffer of each version
+	 *
+	 * The octets past the end of either version are 0, and so are
+	 * the octets of the last word past the end of the new version.
+	 */
+	if (stats_wanted) {
+	    stats_report(0);
+	}
+	stats_switch(read_phase);
+	len = (newlen - pos < CHUNK) ? newlen - pos : CHUNK;
+	oldcnt = (pos >= oldlen) ? 0 : ((oldlen - pos < len) ? oldlen - pos : len);
+	nwords = (len + DELTA_WORD - 1) / DELTA_WORD;
+	newbuf[nwords-1] = 0;
+	read_version(newf, argv[1], newbuf, len);
+	if (oldcnt < nwords * DELTA_WORD) {
+	    memset((u_int8_t *)oldbuf + oldcnt, 0, nwords * DELTA_WORD - oldcnt);
+	}
+	read_version(oldf, argv[0], oldbuf, oldcnt);
+	stats_bytes(read_phase, len + oldcnt);
+	octets_read += len + oldcnt;
+
+	/*
+	 * XOR the versions and write each run of changed words
+	 */
+	stats_switch(diff_phase);
+	stats_bytes(diff_phase, len + oldcnt);
+	for (w = 0; w < nwords; ++w) {
+	    newbuf[w] ^= oldbuf[w];
+	}
+	w = 0;
+	while (w < nwords) {
+	    if (newbuf[w] == 0) {
+		++skip;
+		++w;
+		continue;
+	    }
+	    run = w;
+	    while (w < nwords && newbuf[w] != 0) {
+		++w;
+	    }
+	    put_varint(skip);
+	    put_varint(w - run);
+	    fwrite(newbuf + run, DELTA_WORD, w - run, stdout);
+	    octets_written += (w - run) * DELTA_WORD;
+	    words_changed += w - run;
+	    ++records_written;
+	    skip = 0;
+	}
+	if (ferror(stdout)) {
+	    fprintf(stderr, "%s: write error: %s\n", program, strerror(errno));
+	    exit(7);
+	}
+    }
+
+    /*
+     * write the end of the delta
+     */
+    put_varint(0);
+    put_varint(0);
+    if (fflush(stdout) != 0 || ferror(stdout)) {
+	fprintf(stderr, "%s: write error: %s\n", program, strerror(errno));
+	exit(7);
+    }
+
+    /*
+     * report hardware counters if -p
+     */
+    perfctr_stop(octets_read);
+
+    /*
+     * report stats if -s
+     */
+    if (stats_on) {
+	stats_switch(-1);
+	stats_report(1);
+    }
+
+    /*
+     * All done!
+     *
+     *	-- Jessica Noll, 1985
+     */
+    exit(0);
+}
+
+
+/*
+ * open_version - open a version of the bitmap file
+ *
+ * given:
+ *	filename	bitmap file to open
+ *	len		set to the octets in the bitmap file
+ *
+ * returns:
+ *	open stream of filename
+ */
+static FILE *
+open_version(const char *filename, unsigned long long *len)
+{
+    FILE *stream;	/* open bitmap file */
+    struct stat sbuf;	/* bitmap file status */
+
+    stream = fopen(filename, "r");
+    if (stream == NULL || fstat(fileno(stream), &sbuf) < 0) {
+	fprintf(stderr, "%s: cannot open %s: %s\n", program, filename, strerror(errno));
+	exit(4);
+    }
+    if (!S_ISREG(sbuf.st_mode)) {
+	fprintf(stderr, "%s: %s is not a regular file\n", program, filename);
+	exit(4);
+    }
+    *len = sbuf.st_size;
+    return stream;
+}
+
+
+/*
+ * sum_version - find the checksum of a version of the bitmap file
+ *
+ * given:
+ *	stream		open bitmap file
+ *	filename	name of the bitmap file
+ *	len		octets in the bitmap file
+ *
+ * returns:
+ *	checksum of the bitmap file, with stream rewound to its start
+ */
+static unsigned long long
+sum_version(FILE *stream, const char *filename, unsigned long long len)
+{
+    unsigned long long sum;	/* checksum so far */
+    unsigned long long pos;	/* octet offset of the buffer */
+    unsigned long cnt;		/* octets in the buffer */
+
+    sum = DELTA_SUM_INIT;
+    for (pos = 0; pos < len; pos += cnt) {
+	if (stats_wanted) {
+	    stats_report(0);
+	}
+	cnt = (len - pos < CHUNK) ? len - pos : CHUNK;
+	read_version(stream, filename, oldbuf, cnt);
+	sum = delta_sum(sum, (u_int8_t *)oldbuf, cnt);
+	octets_read += cnt;
+    }
+    if (fseek(stream, 0, SEEK_SET) < 0) {
+	fprintf(stderr, "%s: cannot rewind %s: %s\n", program, filename, strerror(errno));
+	exit(6);
+    }
+    return sum;
+}
+
+
+/*
+ * read_version - read the next octets of a version of the bitmap file
+ *
+ * given:
+ *	stream		open bitmap file
+ *	filename	name of the bitmap file
+ *	buf		where to read
+ *	len		octets to read
+ *
+ * A file that ends early has changed since its length was found, which
+ * is reported as a read error.
+ */
+static void
+read_version(FILE *stream, const char *filename, u_int64_t *buf, unsigned long len)
+{
+    if (len == 0) {
+	return;
+    }
+    clearerr(stream);
+    if (fread(buf, 1, len, stream) != len) {
+	if (ferror(stream)) {
+	    fprintf(stderr, "%s: read error on %s: %s\n", program, filename, strerror(errno));
+	} else {
+	    fprintf(stderr, "%s: %s became shorter while being read\n", program, filename);
+	}
+	exit(6);
+    }
+    return;
+}
+
+
+/*
+ * put_u64 - write an 8 octet little-endian integer on stdout
+ *
+ * given:
+ *	value		integer to write
+ */
+static void
+put_u64(unsigned long long value)
+{
+    int i;
+
+    for (i=0; i < 8; ++i) {
+	putchar(value & 0xff);
+	value >>= 8;
+    }
+    octets_written += 8;
+    return;
+}
+
+
+/*
+ * put_varint - write a varint on stdout
+ *
+ * given:
+ *	value		integer to write
+ */
+static void
+put_varint(unsigned long long value)
+{
+    while (value >= 0x80) {
+	putchar((value & 0x7f) | 0x80);
+	value >>= 7;
+	++octets_written;
+    }
+    putchar(value);
+    ++octets_written;
+    return;
+}
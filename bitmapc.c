@@ -0,0 +1,611 @@
+/*
+ * bitmapc - count, list and query the bitmaps of a bitmapd daemon
+ *
+ * We will connect to the Unix domain socket of bitmapd and ask it about
+ * one of the bitmaps it serves, by name.  bitmapc answers as popcnt,
+ * listbit and bitquery do, but without reading the bitmap itself.
+ *
+ * By default, we write the count of the 0 bits, the 1 bits or all the
+ * bits of the bitmap, as popcnt does.  With -l, we list the values of
+ * the 1 bits of the bitmap one per line, as listbit does with a type
+ * of 1.  With -r lo,hi as well, only the bits of the values from lo to
+ * hi are counted or listed.
+ *
+ * With -q, we read values from stdin, one per line, and for each value
+ * write 1 if its bit in the bitmap is set, or 0 if it is not, as bitquery
+ * does.  With -N, for each value we write the smallest value >= it whose
+ * bit is set instead, or "none", as bitquery -N does.  A malformed input
+ * line is reported on stderr and answered 0 (or "none"), so that the
+ * answers stay in input order.  Values are sent in batches of BATCH
+ * requests before their replies are read, so that a batch costs one
+ * round trip.
+ *
+ * The requests and replies are described in bitmapd.h.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "bitmapd.h"
+
+
+/*
+ * official version
+ */
+#define VERSION "1.0.0 2026-10-19"          /* format: major.minor YYYY-MM-DD */
+
+
+/*
+ * useful defines
+ */
+#define MAXLINE (1+19+1)	/* signed 19 digit value + newline */
+#define BATCH (512)		/* values sent before their replies are read */
+
+/*
+ * what we will ask
+ */
+#define ASK_COUNT (0)		/* count bits */
+#define ASK_LIST (1)		/* list set values */
+#define ASK_MEMBER (2)		/* is each value set */
+#define ASK_NEXT (3)		/* smallest set value >= each value */
+
+
+/*
+ * usage message
+ */
+static const char * const usage =
+  "usage: %s [-h] [-V] [-r lo,hi] [-l | -q | -N] socket name [type]\n"
+        "\n"
+        "    -h            print help message and exit\n"
+        "    -V            print version string and exit\n"
+        "    -r lo,hi      only count or list the bits of values lo to hi\n"
+        "    -l            list the set values, one per line\n"
+        "    -q            write 1 or 0 for whether each value on stdin is set\n"
+        "    -N            write the next set value >= each value on stdin\n"
+        "\n"
+        "    socket        Unix domain socket of bitmapd\n"
+        "    name          name of the bitmap\n"
+        "    type          0 ==> count 0 bits, 1 ==> count 1 bits, 2 ==> count bits\n"
+        "                  (only without -l, -q and -N)\n"
+        "\n"
+        "Exit codes:\n"
+        "    0         all OK\n"
+        "    2         -h and help string printed or -V and version string printed\n"
+        "    3         command line error\n"
+        "    4         cannot connect to bitmapd\n"
+        "    5         bitmapd has no such bitmap or refused the request\n"
+        "    6         read error or bitmapd closed the connection\n"
+        "    7         write error\n"
+        " >= 10        internal error\n"
+        "\n"
+        "%s version: %s\n";
+
+
+/*
+ * static declarations
+ */
+static char *program = NULL;    /* our name */
+static char *prog = NULL;       /* basename of program */
+static const char * const version = VERSION;
+static const char *name = NULL;	/* name of the bitmap */
+static FILE *to_server = NULL;	/* requests to bitmapd */
+static FILE *from_server = NULL;	/* replies from bitmapd */
+
+/*
+ * current batch of -q or -N values
+ */
+static unsigned long batch_value[BATCH];	/* values of the batch */
+static u_int8_t batch_bad[BATCH];		/* 1 ==> malformed input value */
+
+
+/*
+ * static functions
+ */
+static void connect_server(const char *path);
+static void send_request(int op, unsigned long long a, unsigned long long b,
+			 unsigned long long c);
+static unsigned long long get_reply(unsigned long long *values, unsigned long long max);
+static void ask_list(unsigned long lo, unsigned long hi);
+static void ask_values(int ask);
+static int read_text(void);
+static void write_check(void);
+
+
+int
+main(int argc, char *argv[])
+{
+    int ask = ASK_COUNT;	/* what we will ask */
+    int ranged = 0;		/* 1 ==> -r lo,hi given */
+    unsigned long lo = 0;	/* -r lowest value */
+    unsigned long hi = ~0UL;	/* -r highest value */
+    long type = 0;		/* type of bits to count */
+    unsigned long long count;	/* count of bits */
+    char *p;			/* parse pointer */
+    char *q;			/* start of -r hi */
+    int i;
+
+    /*
+     * parse args
+     */
+    program = argv[0];
+    prog = rindex(program, '/');
+    if (prog == NULL) {
+        prog = program;
+    } else {
+        ++prog;
+    }
+    while ((i = getopt(argc, argv, ":hVr:lqN")) != -1) {
+	switch (i) {
+
+        case 'h':                   /* -h - print help message and exit */
+	    fprintf(stderr, usage, program, prog, version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 'V':                   /* -V - print version string and exit */
+            (void) printf("%s\n", version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 'r':                   /* -r lo,hi - range of values */
+	    errno = 0;
+	    lo = strtoll(optarg, &p, 0);
+	    if (p > optarg && *p == ',') {
+		q = p+1;
+		hi = strtoll(q, &p, 0);
+		if (p == q) {
+		    p = optarg;
+		}
+	    } else {
+		p = optarg;
+	    }
+	    if (errno == ERANGE || p == optarg || *p != '\0') {
+		fprintf(stderr, "%s: -r must be lo,hi: %s\n", program, optarg);
+		fprintf(stderr, usage, program, prog, version);
+		exit(3); /* ooo */
+		/*NOTREACHED*/
+	    }
+	    ranged = 1;
+	    break;
+
+	case 'l':                   /* -l - list set values */
+	    ask = ASK_LIST;
+	    break;
+
+	case 'q':                   /* -q - membership of values on stdin */
+	    ask = ASK_MEMBER;
+	    break;
+
+	case 'N':                   /* -N - next set value of values on stdin */
+	    ask = ASK_NEXT;
+	    break;
+
+	case ':':
+            (void) fprintf(stderr, "%s: ERROR: requires an argument -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        case '?':
+            (void) fprintf(stderr, "%s: ERROR: illegal option -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        default:
+            fprintf(stderr, "%s: ERROR: invalid -flag\n", program);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+        }
+    }
+    /* skip over command line options */
+    argv += optind;
+    argc -= optind;
+    /* check the arg count */
+    if (argc != ((ask == ASK_COUNT) ? 3 : 2)) {
+        fprintf(stderr, "%s: ERROR: expected %d args, found: %d\n",
+		program, (ask == ASK_COUNT) ? 3 : 2, argc);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if (ranged && ask != ASK_COUNT && ask != ASK_LIST) {
+	fprintf(stderr, "%s: -r conflicts with -q and -N\n", program);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    name = argv[1];
+    if (strlen(name) == 0 || strlen(name) > BITMAPD_NAME_MAX) {
+	fprintf(stderr, "%s: bitmap name must be 1 to %d chars: %s\n",
+		program, BITMAPD_NAME_MAX, name);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if (ask == ASK_COUNT) {
+	type = strtol(argv[2], NULL, 0);
+	if (type < 0 || type > 2 || !isdigit(argv[2][0])) {
+	    fprintf(stderr, "%s: type must be 0, 1 or 2: %s\n", program, argv[2]);
+	    fprintf(stderr, usage, program, prog, version);
+	    exit(3); /* ooo */
+	    /*NOTREACHED*/
+	}
+    }
+
+    /*
+     * ask bitmapd
+     */
+    connect_server(argv[0]);
+    switch (ask) {
+    case ASK_COUNT:
+	if (ranged) {
+	    send_request(BITMAPD_OP_RANGE, lo, hi, type);
+	} else {
+	    send_request(BITMAPD_OP_COUNT, type, 0, 0);
+	}
+	if (get_reply(&count, 1) != 1) {
+	    fprintf(stderr, "%s: bitmapd sent no count\n", program);
+	    exit(6);
+	}
+	printf("%lld\n", count);
+	break;
+    case ASK_LIST:
+	ask_list(lo, hi);
+	break;
+    default:
+	ask_values(ask);
+	break;
+    }
+    write_check();
+
+    /*
+     * All done!
+     *
+     *	-- Jessica Noll, 1985
+     */
+    exit(0);
+}
+
+
+/*
+ * connect_server - connect to bitmapd
+ *
+ * given:
+ *	path	socket path of bitmapd
+ */
+static void
+connect_server(const char *path)
+{
+    struct sockaddr_un addr;	/* socket address */
+    int fd;			/* connection */
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+	fprintf(stderr, "%s: socket path longer than %d chars: %s\n",
+		program, (int)sizeof(addr.sun_path) - 1, path);
+	exit(3);
+    }
+    strcpy(addr.sun_path, path);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+	fprintf(stderr, "%s: cannot connect to %s: %s\n", program, path, strerror(errno));
+	exit(4);
+    }
+    from_server = fdopen(fd, "r");
+    to_server = fdopen(dup(fd), "w");
+    if (from_server == NULL || to_server == NULL) {
+	fprintf(stderr, "%s: cannot open connection streams: %s\n", program, strerror(errno));
+	exit(10);
+    }
+    return;
+}
+
+
+/*
+ * send_request - buffer a request to bitmapd
+ *
+ * given:
+ *	op	one of the BITMAPD_OP_ values
+ *	a	arg a
+ *	b	arg b
+ *	c	arg c
+ *
+ * The request is not sent until to_server is flushed.
+ */
+static void
+send_request(int op, unsigned long long a, unsigned long long b, unsigned long long c)
+{
+    u_int8_t req[BITMAPD_REQUEST_LEN];	/* request */
+    unsigned long long arg[3];		/* args a, b and c */
+    int i;
+    int j;
+
+    memset(req, 0, sizeof(req));
+    req[0] = op;
+    req[1] = strlen(name);
+    arg[0] = a;
+    arg[1] = b;
+    arg[2] = c;
+    for (i=0; i < 3; ++i) {
+	for (j=0; j < 8; ++j) {
+	    req[8 + 8*i + j] = arg[i] & 0xff;
+	    arg[i] >>= 8;
+	}
+    }
+    clearerr(to_server);
+    if (fwrite(req, 1, sizeof(req), to_server) != sizeof(req) ||
+	fwrite(name, 1, req[1], to_server) != req[1]) {
+	fprintf(stderr, "%s: cannot write request: %s\n", program, strerror(errno));
+	exit(7);
+    }
+    return;
+}
+
+
+/*
+ * get_reply - read a reply from bitmapd
+ *
+ * given:
+ *	values	where to read the values of the reply
+ *	max	max values the reply may have
+ *
+ * returns:
+ *	number of values read
+ *
+ * The requests buffered so far are sent first.
+ */
+static unsigned long long
+get_reply(unsigned long long *values, unsigned long long max)
+{
+    u_int8_t buf[BITMAPD_REPLY_LEN];	/* reply header, then a value */
+    unsigned long long n;		/* values of the reply */
+    unsigned long long i;
+    int j;
+
+    /*
+     * send the requests, then read the reply header
+     */
+    if (fflush(to_server) != 0) {
+	fprintf(stderr, "%s: cannot write request: %s\n", program, strerror(errno));
+	exit(7);
+    }
+    if (fread(buf, 1, BITMAPD_REPLY_LEN, from_server) != BITMAPD_REPLY_LEN) {
+	fprintf(stderr, "%s: no reply from bitmapd\n", program);
+	exit(6);
+    }
+    switch (buf[0]) {
+    case BITMAPD_STATUS_OK:
+	break;
+    case BITMAPD_STATUS_NO_BITMAP:
+	fprintf(stderr, "%s: bitmapd has no bitmap named: %s\n", program, name);
+	exit(5);
+    default:
+	fprintf(stderr, "%s: bitmapd refused the request, status: %d\n", program, buf[0]);
+	exit(5);
+    }
+    n = 0;
+    for (j=7; j >= 0; --j) {
+	n = (n << 8) | buf[8+j];
+    }
+    if (n > max) {
+	fprintf(stderr, "%s: bitmapd sent %lld values, expected at most %lld\n",
+		program, n, max);
+	exit(6);
+    }
+
+    /*
+     * read the values
+     */
+    for (i=0; i < n; ++i) {
+	if (fread(buf, 1, BITMAPD_VALUE_LEN, from_server) != BITMAPD_VALUE_LEN) {
+	    fprintf(stderr, "%s: truncated reply from bitmapd\n", program);
+	    exit(6);
+	}
+	values[i] = 0;
+	for (j=BITMAPD_VALUE_LEN-1; j >= 0; --j) {
+	    values[i] = (values[i] << 8) | buf[j];
+	}
+    }
+    return n;
+}
+
+
+/*
+ * ask_list - list the set values from lo to hi
+ *
+ * given:
+ *	lo	lowest value to list
+ *	hi	highest value to list
+ *
+ * A full reply may not hold all of the set values, so we ask again
+ * from just beyond its last value.
+ */
+static void
+ask_list(unsigned long lo, unsigned long hi)
+{
+    static unsigned long long values[BITMAPD_LIST_MAX];	/* values of a reply */
+    unsigned long long n;	/* values of a reply */
+    unsigned long long i;
+
+    do {
+	send_request(BITMAPD_OP_LIST, lo, hi, BITMAPD_LIST_MAX);
+	n = get_reply(values, BITMAPD_LIST_MAX);
+	for (i=0; i < n; ++i) {
+	    printf("%lld\n", values[i]);
+	}
+	write_check();
+	if (n > 0) {
+	    if (values[n-1] >= hi) {
+		break;
+	    }
+	    lo = values[n-1] + 1;
+	}
+    } while (n == BITMAPD_LIST_MAX);
+    return;
+}
+
+
+/*
+ * ask_values - answer batches of values read on stdin until EOF
+ *
+ * given:
+ *	ask	ASK_MEMBER or ASK_NEXT
+ */
+static void
+ask_values(int ask)
+{
+    unsigned long long value;	/* value of a reply */
+    int n;			/* values in the current batch */
+    int i;
+
+    do {
+	/*
+	 * send the requests of the batch
+	 */
+	n = read_text();
+	for (i=0; i < n; ++i) {
+	    if (!batch_bad[i]) {
+		send_request((ask == ASK_MEMBER) ? BITMAPD_OP_MEMBER : BITMAPD_OP_NEXT,
+			     batch_value[i], 0, 0);
+	    }
+	}
+
+	/*
+	 * write the answers in input order
+	 */
+	for (i=0; i < n; ++i) {
+	    if (ask == ASK_MEMBER) {
+		if (batch_bad[i] || get_reply(&value, 1) != 1) {
+		    value = 0;
+		}
+		putchar('0' + (value != 0));
+		putchar('\n');
+	    } else if (batch_bad[i] || get_reply(&value, 1) != 1) {
+		fputs("none\n", stdout);
+	    } else {
+		printf("%lld\n", value);
+	    }
+	}
+	write_check();
+    } while (n == BATCH);
+    return;
+}
+
+
+/*
+ * read_text - read a batch of values, one per line
+ *
+ * returns:
+ *	number of values read into batch_value[], < BATCH ==> EOF
+ *
+ * A malformed line is reported on stderr and marked in batch_bad[].
+ */
+static int
+read_text(void)
+{
+    static char inbuf[MAXLINE+1];	/* max input line + NUL byte */
+    static long line = 0;		/* input line number */
+    char *p;	/* char check pointer */
+    int n;
+
+    for (n=0; n < BATCH; ++n) {
+
+	/*
+	 * read a line
+	 */
+	clearerr(stdin);
+	if (fgets(inbuf, MAXLINE+1, stdin) == NULL) {
+	    if (ferror(stdin)) {
+		fprintf(stderr, "%s: read error: %s\n", program, strerror(errno));
+		exit(6);
+	    }
+	    break;	/* EOF found */
+	}
+	++line;
+
+	/*
+	 * input must be an integer (with a possible leading -) followed by
+	 * a newline, or by EOF on the last line
+	 */
+	p = ((inbuf[0] == '-') ? inbuf+1 : inbuf);
+	while (*p != '\0' && isdigit(*p)) {
+	    ++p;
+	}
+	if (p == inbuf || !isdigit(*(p-1)) || (*p != '\n' && *p != '\0') ||
+	    (*p == '\0' && !feof(stdin))) {
+	    fprintf(stderr, "%s: line %ld: invalid value, answering 0\n", program, line);
+	    /* skip the rest of a line that is too long */
+	    while (strchr(inbuf, '\n') == NULL) {
+		if (fgets(inbuf, MAXLINE+1, stdin) == NULL) {
+		    break;
+		}
+	    }
+	    batch_bad[n] = 1;
+	    continue;
+	}
+
+	/*
+	 * convert the line
+	 */
+	batch_bad[n] = 0;
+	errno = 0;
+	batch_value[n] = strtoll(inbuf, NULL, 0);
+	if (errno == ERANGE) {
+	    fprintf(stderr, "%s: line %ld: value out of range, answering 0\n", program, line);
+	    batch_bad[n] = 1;
+	}
+    }
+    return n;
+}
+
+
+/*
+ * write_check - exit on a stdout write error
+ */
+static void
+write_check(void)
+{
+    if (fflush(stdout) != 0 || ferror(stdout)) {
+	fprintf(stderr, "%s: write error: %s\n", program, strerror(errno));
+	exit(7);
+    }
+    return;
+}
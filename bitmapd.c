@@ -0,0 +1,1414 @@
+/*
+ * bitmapd - answer count, membership and list queries of resident bitmaps
+ *
+ * We will map one or more bitmap files into memory, build an index of
+ * each, and answer requests for them that clients write on a Unix domain
+ * socket, until SIGINT or SIGTERM is received.  A query then costs one
+ * round trip instead of starting a process, opening the bitmap and
+ * scanning it.  bitmapc is the client.  The requests and replies are
+ * described in bitmapd.h.  They count the 0 or 1 bits of a whole bitmap
+ * or of a range of values, test whether a value is set, find the next
+ * set value, and list the set values of a range.
+ *
+ * Each bitmap is given as name,start,step,bitmap where bitmap is the
+ * bitmap file and name is how requests refer to it.  The bitmap
+ * represents values as written by bitset, i.e., the bit of octet 'x'
+ * bit 'y' represents start + step*(x*8 + y).  With -w, every bitmap uses
+ * the mod 30 wheel layout (see wheel.h) and its step must be 30.
+ *
+ * Two indexes are built for each bitmap.  A rank index holds the count
+ * of 1 bits before every RANK_BLOCK octets, so the 1 bits before any bit
+ * are counted by reading at most RANK_BLOCK octets.  A summary holds one
+ * bit per 4 KiB block that has a set bit (see bitscan.h), so the next set
+ * bit is found by skipping empty blocks without reading them.
+ *
+ * A pool of threads answers requests.  The main thread waits with poll()
+ * for any connection to have requests to read, and queues it for the
+ * next idle thread.  That thread answers the complete requests it can
+ * read without waiting, writes their replies, keeps the start of any
+ * request still to come, and hands the connection back to the main
+ * thread.  So an idle client does not hold a thread.  A thread only
+ * waits for a client that does not read its replies, and then for at
+ * most SEND_WAIT milliseconds at a time.  With -n threads, that many
+ * threads answer requests, else one per online CPU.  At most MAX_CONN
+ * connections are open at once; a connection beyond that is closed as
+ * soon as it is accepted.  When out of file descriptors, bitmapd stops
+ * accepting until a connection is closed, or for ACCEPT_WAIT milliseconds.
+ *
+ * On SIGHUP, every bitmap file is mapped again and its indexes rebuilt.
+ * A bitmap file that cannot be opened or mapped then is reported, and
+ * its old map and indexes are kept.
+ * A bitmap file should be changed by writing a new file and renaming it
+ * over the old one, then sending SIGHUP.  The indexes of a bitmap file
+ * changed in place, such as by bitupdate or bitpatch, are out of date
+ * until SIGHUP.  bitupdate and bitpatch never make a bitmap file shorter
+ * in place: a shorter bitmap is written to a new file that is renamed
+ * over the old one, so the map of bitmapd stays valid until SIGHUP.
+ * Truncating a mapped bitmap file in place by other means kills bitmapd
+ * with SIGBUS when it reads beyond the new end.
+ *
+ * With -s, counters of connections, requests answered, bad requests and
+ * values sent are written as JSON on stderr at exit.  The same report is
+ * written when SIGUSR1 is received.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "stats.h"
+#include "wheel.h"
+#include "bitscan.h"
+#include "bitmapd.h"
+
+
+/*
+ * official version
+ */
+#define VERSION "1.0.0 2026-10-19"          /* format: major.minor YYYY-MM-DD */
+
+
+/*
+ * useful defines
+ */
+#define OCTETBITS (8)		/* 8 bits per octet */
+#define RANK_BLOCK (512)	/* bitmap octets per rank index entry */
+#define CONN_BUF (65536)	/* octets of a thread read or write buffer */
+#define MAX_CONN (4096)		/* max open connections, more are refused */
+#define SEND_WAIT (10000)	/* ms to wait for a client to read replies */
+#define ACCEPT_WAIT (1000)	/* ms to wait before accepting again after EMFILE */
+#define PART_MAX (BITMAPD_REQUEST_LEN + BITMAPD_NAME_MAX)  /* max request */
+
+
+/*
+ * usage message
+ */
+static const char * const usage =
+  "usage: %s [-h] [-V] [-s] [-w] [-n threads] socket name,start,step,bitmap ...\n"
+        "\n"
+        "    -h            print help message and exit\n"
+        "    -V            print version string and exit\n"
+        "    -s            write stats as JSON on stderr at exit and on SIGUSR1\n"
+        "    -w            use the mod 30 wheel layout (step must be 30)\n"
+        "    -n threads    threads answering requests (def: one per online CPU)\n"
+        "\n"
+        "    socket        Unix domain socket to listen on\n"
+        "    name          name of the bitmap in requests\n"
+        "    start         starting bitmap value\n"
+        "    step          step values between bits\n"
+        "    bitmap        bitmap file\n"
+        "\n"
+        "Exit codes:\n"
+        "    0         all OK, SIGINT or SIGTERM received\n"
+        "    2         -h and help string printed or -V and version string printed\n"
+        "    3         command line error\n"
+        "    4         cannot open or map a bitmap file at startup\n"
+        "    5         cannot listen on or accept from the socket\n"
+        " >= 10        internal error\n"
+        "\n"
+        "%s version: %s\n";
+
+
+/*
+ * static declarations
+ */
+static char *program = NULL;    /* our name */
+static char *prog = NULL;       /* basename of program */
+static const char * const version = VERSION;
+
+/*
+ * bitmaps
+ *
+ * The maps and indexes are only changed by the main thread, on SIGHUP,
+ * while it holds map_lock for writing.  Threads answering requests hold
+ * map_lock for reading.
+ */
+static struct bitmap {
+    char *name;			/* name of the bitmap in requests */
+    char *filename;		/* bitmap file */
+    unsigned long start;	/* starting bitmap value */
+    unsigned long step;		/* bitmap increment value */
+    const u_int8_t *map;	/* mapped bitmap file, NULL ==> empty */
+    unsigned long maplen;	/* octets in the bitmap file */
+    u_int8_t *summary;		/* summary of the bitmap */
+    unsigned long long *rank;	/* 1 bits before each RANK_BLOCK octets */
+    unsigned long long ones;	/* 1 bits in the bitmap */
+} *bitmap = NULL;
+static int nbitmaps = 0;		/* number of bitmaps */
+static int wheel = 0;			/* 1 ==> -w mod 30 wheel layout */
+static pthread_rwlock_t map_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/*
+ * connections
+ *
+ * The main thread owns a connection while it waits for requests.  A
+ * thread answering requests owns it from when it is taken off ready
+ * until it is put on returned.  Both lists are guarded by queue_lock.
+ */
+struct conn {
+    int fd;			/* connection file descriptor */
+    int eof;			/* 1 ==> client closed or read error */
+    int dead;			/* 1 ==> write error, stop answering */
+    size_t partlen;		/* octets of part */
+    u_int8_t part[PART_MAX];	/* start of a request still to come */
+    struct conn *next;		/* next connection of ready or returned */
+};
+static struct conn *ready_head = NULL;	/* oldest connection with requests */
+static struct conn *ready_tail = NULL;	/* newest connection with requests */
+static struct conn *returned = NULL;	/* connections handed back */
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static int wake_pipe[2] = { -1, -1 };	/* written to wake the main thread */
+
+/*
+ * a thread answering requests
+ *
+ * Replies are buffered until the requests read have been answered, so
+ * that a client that writes many requests before reading their replies
+ * gets them in a few large writes.
+ */
+struct worker {
+    struct conn *c;		/* connection being answered */
+    size_t outlen;		/* octets of out to write */
+    u_int64_t *values;		/* values of a reply */
+    u_int8_t in[CONN_BUF];	/* requests read */
+    u_int8_t out[CONN_BUF];	/* replies to write */
+};
+
+/*
+ * signals seen by the main thread
+ *
+ * The signal handler also writes to wake_pipe, so that a signal is
+ * never lost between testing for it and waiting in poll().
+ */
+static volatile sig_atomic_t want_quit = 0;	/* SIGINT or SIGTERM */
+static volatile sig_atomic_t want_reload = 0;	/* SIGHUP */
+
+/*
+ * stats counters, see -s
+ *
+ * Except for those of connections, which only the main thread counts,
+ * the counters are incremented atomically by the threads answering
+ * requests.
+ */
+static unsigned long long connections = 0;	/* connections accepted */
+static unsigned long long refused = 0;		/* connections beyond MAX_CONN */
+static unsigned long long requests = 0;		/* requests answered */
+static unsigned long long bad_requests = 0;	/* requests not answered OK */
+static unsigned long long values_sent = 0;	/* reply values written */
+
+
+/*
+ * static functions
+ */
+static void add_bitmap(const char *spec);
+static int map_bitmap(struct bitmap *bm);
+static void unmap_bitmap(struct bitmap *bm);
+static int listen_socket(const char *path);
+static void catch_signal(int sig);
+static void wake_main(void);
+static void *serve(void *arg);
+static void answer(struct worker *w, const u_int8_t *req, const char *name);
+static struct bitmap *find_bitmap(const char *name);
+static unsigned long long rank_of(const struct bitmap *bm, unsigned long bit);
+static unsigned long bit_ceil(const struct bitmap *bm, unsigned long value);
+static unsigned long bit_end(const struct bitmap *bm, unsigned long value);
+static unsigned long value_of(const struct bitmap *bm, unsigned long bit);
+static void conn_write(struct worker *w, const void *buf, size_t len);
+static void conn_flush(struct worker *w);
+static unsigned long long get_u64(const u_int8_t *buf);
+static void put_u64(u_int8_t *buf, unsigned long long value);
+
+
+int
+main(int argc, char *argv[])
+{
+    long nthreads = 0;		/* -n threads, 0 ==> one per online CPU */
+    char *sockname;		/* socket to listen on */
+    pthread_t thread;		/* thread answering requests */
+    struct sigaction sa;	/* signal action */
+    sigset_t block;		/* signals caught by the main thread */
+    sigset_t oldmask;		/* signal mask of the main thread */
+    struct pollfd *pfd;		/* wake_pipe, listen socket, idle connections */
+    struct conn **idle;		/* connections waiting for requests */
+    int nidle = 0;		/* connections in idle */
+    int nconns = 0;		/* open connections */
+    int accepting = 1;		/* 0 ==> out of file descriptors */
+    int ready;			/* file descriptors poll() found ready */
+    struct conn *c;		/* a connection */
+    struct conn *back;		/* connections handed back */
+    struct bitmap remap;	/* bitmap mapped again on SIGHUP */
+    struct bitmap old;		/* bitmap replaced on SIGHUP */
+    char drain[64];		/* octets read from wake_pipe */
+    int lfd;			/* listen file descriptor */
+    int fd;			/* accepted connection */
+    int ret;
+    int i;
+
+    /*
+     * parse args
+     */
+    program = argv[0];
+    prog = rindex(program, '/');
+    if (prog == NULL) {
+        prog = program;
+    } else {
+        ++prog;
+    }
+    while ((i = getopt(argc, argv, ":hVswn:")) != -1) {
+	switch (i) {
+
+        case 'h':                   /* -h - print help message and exit */
+	    fprintf(stderr, usage, program, prog, version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 'V':                   /* -V - print version string and exit */
+            (void) printf("%s\n", version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 's':                   /* -s - write stats */
+	    stats_setup(prog);
+	    break;
+
+	case 'w':                   /* -w - mod 30 wheel layout */
+	    wheel = 1;
+	    break;
+
+	case 'n':                   /* -n threads - threads answering requests */
+	    errno = 0;
+	    nthreads = strtol(optarg, NULL, 0);
+	    if (errno == ERANGE || nthreads <= 0) {
+		fprintf(stderr, "%s: threads must be > 0: %s\n", program, optarg);
+		fprintf(stderr, usage, program, prog, version);
+		exit(3); /* ooo */
+		/*NOTREACHED*/
+	    }
+	    break;
+
+	case ':':
+            (void) fprintf(stderr, "%s: ERROR: requires an argument -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        case '?':
+            (void) fprintf(stderr, "%s: ERROR: illegal option -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        default:
+            fprintf(stderr, "%s: ERROR: invalid -flag\n", program);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+        }
+    }
+    /* skip over command line options */
+    argv += optind;
+    argc -= optind;
+    /* check the arg count */
+    if (argc < 2) {
+        fprintf(stderr, "%s: ERROR: expected at least 2 args, found: %d\n", program, argc);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    sockname = argv[0];
+    for (i=1; i < argc; ++i) {
+	add_bitmap(argv[i]);
+    }
+    if (nthreads == 0) {
+	nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads < 1) {
+	    nthreads = 1;
+	}
+    }
+
+    /*
+     * map the bitmaps and build their indexes
+     */
+    for (i=0; i < nbitmaps; ++i) {
+	if (map_bitmap(&bitmap[i]) != 0) {
+	    exit(4);
+	}
+    }
+    stats_counter("connections", &connections);
+    stats_counter("refused", &refused);
+    stats_counter("requests", &requests);
+    stats_counter("bad_requests", &bad_requests);
+    stats_counter("values_sent", &values_sent);
+
+    idle = malloc(MAX_CONN * sizeof(idle[0]));
+    pfd = malloc((MAX_CONN + 2) * sizeof(pfd[0]));
+    if (idle == NULL || pfd == NULL) {
+	fprintf(stderr, "%s: cannot allocate %d connections\n", program, MAX_CONN);
+	exit(10);
+    }
+    if (pipe(wake_pipe) < 0 ||
+	fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK) < 0 ||
+	fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK) < 0) {
+	fprintf(stderr, "%s: cannot create wake pipe: %s\n", program, strerror(errno));
+	exit(10);
+    }
+
+    /*
+     * catch signals in the main thread only
+     *
+     * The signals we catch are blocked while the threads answering
+     * requests are created, so that they inherit the blocked mask.  A
+     * client that goes away must not kill us, so SIGPIPE is ignored.
+     */
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = SIG_IGN;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPIPE, &sa, NULL) < 0) {
+	fprintf(stderr, "%s: cannot ignore SIGPIPE: %s\n", program, strerror(errno));
+	exit(10);
+    }
+    sa.sa_handler = catch_signal;
+    if (sigaction(SIGINT, &sa, NULL) < 0 || sigaction(SIGTERM, &sa, NULL) < 0 ||
+	sigaction(SIGHUP, &sa, NULL) < 0) {
+	fprintf(stderr, "%s: cannot catch signals: %s\n", program, strerror(errno));
+	exit(10);
+    }
+    if (stats_on && sigaction(SIGUSR1, &sa, NULL) < 0) {
+	fprintf(stderr, "%s: cannot catch SIGUSR1: %s\n", program, strerror(errno));
+	exit(10);
+    }
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    sigaddset(&block, SIGHUP);
+    sigaddset(&block, SIGUSR1);
+    ret = pthread_sigmask(SIG_BLOCK, &block, &oldmask);
+    if (ret != 0) {
+	fprintf(stderr, "%s: cannot block signals: %s\n", program, strerror(ret));
+	exit(10);
+    }
+
+    /*
+     * start the threads answering requests and listen for connections
+     */
+    lfd = listen_socket(sockname);
+    for (i=0; i < nthreads; ++i) {
+	ret = pthread_create(&thread, NULL, serve, NULL);
+	if (ret != 0) {
+	    fprintf(stderr, "%s: cannot create thread: %s\n", program, strerror(ret));
+	    exit(10);
+	}
+	pthread_detach(thread);
+    }
+    ret = pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
+    if (ret != 0) {
+	fprintf(stderr, "%s: cannot unblock signals: %s\n", program, strerror(ret));
+	exit(10);
+    }
+
+    /*
+     * queue connections with requests until SIGINT or SIGTERM
+     */
+    while (!want_quit) {
+
+	/*
+	 * remap the bitmaps on SIGHUP
+	 *
+	 * Each bitmap is mapped again and indexed while requests are
+	 * still answered from the old map, which is only then replaced.
+	 * A bitmap that cannot be mapped again, such as one whose new file
+	 * is not yet in place, keeps its old map.
+	 */
+	if (want_reload) {
+	    want_reload = 0;
+	    for (i=0; i < nbitmaps; ++i) {
+		remap = bitmap[i];
+		if (map_bitmap(&remap) != 0) {
+		    fprintf(stderr, "%s: keeping the old map of %s\n",
+			    program, bitmap[i].filename);
+		    continue;
+		}
+		pthread_rwlock_wrlock(&map_lock);
+		old = bitmap[i];
+		bitmap[i] = remap;
+		pthread_rwlock_unlock(&map_lock);
+		unmap_bitmap(&old);
+	    }
+	}
+	if (stats_wanted) {
+	    stats_report(0);
+	}
+
+	/*
+	 * take back the connections that threads have answered
+	 */
+	pthread_mutex_lock(&queue_lock);
+	back = returned;
+	returned = NULL;
+	pthread_mutex_unlock(&queue_lock);
+	while (back != NULL) {
+	    c = back;
+	    back = c->next;
+	    if (c->eof || c->dead) {
+		(void) close(c->fd);
+		free(c);
+		--nconns;
+		accepting = 1;
+	    } else {
+		idle[nidle++] = c;
+	    }
+	}
+
+	/*
+	 * wait for a connection, requests, a thread or a signal
+	 */
+	pfd[0].fd = wake_pipe[0];
+	pfd[0].events = POLLIN;
+	pfd[1].fd = accepting ? lfd : -1;
+	pfd[1].events = POLLIN;
+	for (i=0; i < nidle; ++i) {
+	    pfd[i+2].fd = idle[i]->fd;
+	    pfd[i+2].events = POLLIN;
+	}
+	ready = poll(pfd, nidle+2, accepting ? -1 : ACCEPT_WAIT);
+	if (ready < 0) {
+	    if (errno == EINTR) {
+		continue;
+	    }
+	    fprintf(stderr, "%s: cannot wait for a connection: %s\n", program, strerror(errno));
+	    exit(5);
+	}
+	if (ready == 0) {
+	    /* try to accept again, file descriptors may have been freed elsewhere */
+	    accepting = 1;
+	    continue;
+	}
+	if (pfd[0].revents != 0) {
+	    while (read(wake_pipe[0], drain, sizeof(drain)) > 0) {
+	    }
+	}
+
+	/*
+	 * queue the connections with requests, or that the client closed,
+	 * for the next idle thread
+	 */
+	pthread_mutex_lock(&queue_lock);
+	for (i=nidle-1; i >= 0; --i) {
+	    if (pfd[i+2].revents == 0) {
+		continue;
+	    }
+	    c = idle[i];
+	    idle[i] = idle[--nidle];
+	    c->next = NULL;
+	    if (ready_tail == NULL) {
+		ready_head = c;
+	    } else {
+		ready_tail->next = c;
+	    }
+	    ready_tail = c;
+	}
+	if (ready_head != NULL) {
+	    pthread_cond_broadcast(&queue_cond);
+	}
+	pthread_mutex_unlock(&queue_lock);
+
+	/*
+	 * accept a new connection, or refuse it when MAX_CONN are open
+	 */
+	if (pfd[1].revents == 0) {
+	    continue;
+	}
+	fd = accept(lfd, NULL, NULL);
+	if (fd < 0) {
+	    if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK ||
+		errno == ECONNABORTED) {
+		continue;
+	    }
+	    if (errno == EMFILE || errno == ENFILE) {
+		/* stop accepting until a connection is closed or ACCEPT_WAIT */
+		accepting = 0;
+		continue;
+	    }
+	    fprintf(stderr, "%s: cannot accept a connection: %s\n", program, strerror(errno));
+	    exit(5);
+	}
+	if (nconns >= MAX_CONN) {
+	    (void) close(fd);
+	    ++refused;
+	    continue;
+	}
+	c = calloc(1, sizeof(*c));
+	if (c == NULL || fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
+	    (void) close(fd);
+	    free(c);
+	    ++refused;
+	    continue;
+	}
+	c->fd = fd;
+	idle[nidle++] = c;
+	++nconns;
+	++connections;
+    }
+
+    /*
+     * stop listening
+     */
+    (void) close(lfd);
+    (void) unlink(sockname);
+
+    /*
+     * report stats if -s
+     */
+    if (stats_on) {
+	stats_report(1);
+    }
+
+    /*
+     * All done!
+     *
+     *	-- Jessica Noll, 1985
+     */
+    exit(0);
+}
+
+
+/*
+ * add_bitmap - add a bitmap given on the command line
+ *
+ * given:
+ *	spec	name,start,step,bitmap
+ */
+static void
+add_bitmap(const char *spec)
+{
+    struct bitmap *bm;		/* new bitmap */
+    const char *comma;		/* comma after the name */
+    char *p;			/* parse pointer */
+    long long start;		/* starting bitmap value */
+    long long step;		/* bitmap increment value */
+
+    /*
+     * parse name,start,step,bitmap
+     */
+    comma = strchr(spec, ',');
+    if (comma == NULL || comma == spec || comma - spec > BITMAPD_NAME_MAX) {
+	fprintf(stderr, "%s: bitmap must be name,start,step,bitmap with a name of 1 to %d chars: %s\n",
+		program, BITMAPD_NAME_MAX, spec);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    errno = 0;
+    step = 0;
+    start = strtoll(comma+1, &p, 0);
+    if (errno != ERANGE && p > comma+1 && *p == ',') {
+	step = strtoll(p+1, &p, 0);
+    }
+    if (errno == ERANGE || *p != ',' || p[1] == '\0') {
+	fprintf(stderr, "%s: bitmap must be name,start,step,bitmap: %s\n", program, spec);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if (step <= 0) {
+	fprintf(stderr, "%s: step value must be > 0: %s\n", program, spec);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if (wheel && (step != WHEEL_MOD || start % WHEEL_MOD != 0)) {
+	fprintf(stderr, "%s: with -w, step must be %d and start a multiple of %d: %s\n",
+		program, WHEEL_MOD, WHEEL_MOD, spec);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+
+    /*
+     * add the bitmap
+     */
+    bitmap = realloc(bitmap, (nbitmaps+1) * sizeof(bitmap[0]));
+    if (bitmap == NULL) {
+	fprintf(stderr, "%s: cannot allocate %d bitmaps\n", program, nbitmaps+1);
+	exit(10);
+    }
+    bm = &bitmap[nbitmaps];
+    memset(bm, 0, sizeof(*bm));
+    bm->name = strndup(spec, comma - spec);
+    bm->filename = p+1;
+    bm->start = start;
+    bm->step = step;
+    if (bm->name == NULL) {
+	fprintf(stderr, "%s: cannot allocate bitmap name\n", program);
+	exit(10);
+    }
+    if (find_bitmap(bm->name) != NULL) {
+	fprintf(stderr, "%s: bitmap name given more than once: %s\n", program, bm->name);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    ++nbitmaps;
+    return;
+}
+
+
+/*
+ * map_bitmap - map a bitmap file into memory and build its indexes
+ *
+ * given:
+ *	bm	bitmap to map
+ *
+ * returns:
+ *	0 ==> mapped, 1 ==> cannot open or map the bitmap file, which was
+ *	reported, and bm is unchanged
+ *
+ * An empty bitmap file is not mapped; it has no set values.  Queries
+ * touch the bitmap at random, so we ask the kernel not to read ahead
+ * once the indexes are built.
+ */
+static int
+map_bitmap(struct bitmap *bm)
+{
+    struct stat sbuf;	/* bitmap file status */
+    void *addr = NULL;	/* mapped address, NULL ==> empty */
+    u_int64_t word;	/* 64 bits of the bitmap */
+    unsigned long i;
+    int fd;		/* bitmap file descriptor */
+
+    /*
+     * map the bitmap file
+     */
+    fd = open(bm->filename, O_RDONLY);
+    if (fd < 0) {
+	fprintf(stderr, "%s: cannot open %s: %s\n", program, bm->filename, strerror(errno));
+	return 1;
+    }
+    if (fstat(fd, &sbuf) < 0) {
+	fprintf(stderr, "%s: cannot stat %s: %s\n", program, bm->filename, strerror(errno));
+	(void) close(fd);
+	return 1;
+    }
+    if (sbuf.st_size > 0) {
+	addr = mmap(NULL, sbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED) {
+	    fprintf(stderr, "%s: cannot mmap %s: %s\n", program, bm->filename, strerror(errno));
+	    (void) close(fd);
+	    return 1;
+	}
+    }
+    (void) close(fd);
+    bm->maplen = sbuf.st_size;
+    bm->map = addr;
+
+    /*
+     * build the rank index
+     *
+     * rank[i] is the count of 1 bits in the first i*RANK_BLOCK octets.
+     */
+    bm->rank = malloc((bm->maplen / RANK_BLOCK + 1) * sizeof(bm->rank[0]));
+    if (bm->rank == NULL) {
+	fprintf(stderr, "%s: cannot allocate rank index of %s\n", program, bm->filename);
+	exit(10);
+    }
+    bm->ones = 0;
+    for (i=0; i + sizeof(word) <= bm->maplen; i += sizeof(word)) {
+	if (i % RANK_BLOCK == 0) {
+	    bm->rank[i / RANK_BLOCK] = bm->ones;
+	}
+	memcpy(&word, bm->map+i, sizeof(word));
+	bm->ones += __builtin_popcountll(word);
+    }
+    for (; i < bm->maplen; ++i) {
+	if (i % RANK_BLOCK == 0) {
+	    bm->rank[i / RANK_BLOCK] = bm->ones;
+	}
+	bm->ones += __builtin_popcount(bm->map[i]);
+    }
+    if (bm->maplen % RANK_BLOCK == 0) {
+	bm->rank[bm->maplen / RANK_BLOCK] = bm->ones;
+    }
+
+    /*
+     * build the summary
+     */
+    bm->summary = bitscan_summary(bm->map, bm->maplen);
+#if defined(MADV_RANDOM)
+    if (bm->map != NULL) {
+	(void) madvise((void *)bm->map, bm->maplen, MADV_RANDOM);
+    }
+#endif
+    return 0;
+}
+
+
+/*
+ * unmap_bitmap - unmap a bitmap file and free its indexes
+ *
+ * given:
+ *	bm	bitmap to unmap
+ */
+static void
+unmap_bitmap(struct bitmap *bm)
+{
+    if (bm->map != NULL) {
+	(void) munmap((void *)bm->map, bm->maplen);
+	bm->map = NULL;
+    }
+    free(bm->rank);
+    bm->rank = NULL;
+    free(bm->summary);
+    bm->summary = NULL;
+    return;
+}
+
+
+/*
+ * listen_socket - listen on a Unix domain socket
+ *
+ * given:
+ *	path	socket path
+ *
+ * returns:
+ *	listen file descriptor
+ *
+ * A socket left behind by a bitmapd that is no longer running is
+ * replaced.  A socket that accepts connections is in use and is not.
+ * The listen socket does not block, so that a client that goes away
+ * between poll() and accept() does not stop the main thread.
+ */
+static int
+listen_socket(const char *path)
+{
+    struct sockaddr_un addr;	/* socket address */
+    int fd;			/* listen file descriptor */
+    int probe;			/* probe of an existing socket */
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+	fprintf(stderr, "%s: socket path longer than %d chars: %s\n",
+		program, (int)sizeof(addr.sun_path) - 1, path);
+	exit(3);
+    }
+    strcpy(addr.sun_path, path);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+	fprintf(stderr, "%s: cannot create socket: %s\n", program, strerror(errno));
+	exit(5);
+    }
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+	if (errno != EADDRINUSE) {
+	    fprintf(stderr, "%s: cannot bind %s: %s\n", program, path, strerror(errno));
+	    exit(5);
+	}
+	probe = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (probe >= 0 && connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+	    fprintf(stderr, "%s: socket in use: %s\n", program, path);
+	    exit(5);
+	}
+	if (probe >= 0) {
+	    (void) close(probe);
+	}
+	if (unlink(path) < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+	    fprintf(stderr, "%s: cannot bind %s: %s\n", program, path, strerror(errno));
+	    exit(5);
+	}
+    }
+    if (listen(fd, SOMAXCONN) < 0 || fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
+	fprintf(stderr, "%s: cannot listen on %s: %s\n", program, path, strerror(errno));
+	exit(5);
+    }
+    return fd;
+}
+
+
+/*
+ * catch_signal - note a signal for the main thread
+ *
+ * given:
+ *	sig	signal caught
+ */
+static void
+catch_signal(int sig)
+{
+    if (sig == SIGHUP) {
+	want_reload = 1;
+    } else if (sig == SIGUSR1) {
+	stats_wanted = 1;
+    } else {
+	want_quit = 1;
+    }
+    wake_main();
+    return;
+}
+
+
+/*
+ * wake_main - wake the main thread from poll()
+ *
+ * This is called by the signal handler, so it only writes wake_pipe.
+ * When wake_pipe is full, the main thread is already being woken.
+ */
+static void
+wake_main(void)
+{
+    int saved_errno;	/* errno of the code we interrupted */
+
+    saved_errno = errno;
+    (void) write(wake_pipe[1], "", 1);
+    errno = saved_errno;
+    return;
+}
+
+
+/*
+ * serve - answer the requests of ready connections, forever
+ *
+ * given:
+ *	arg	unused
+ *
+ * returns:
+ *	never
+ *
+ * A connection is taken from ready, what its client has written is
+ * read once without waiting, the complete requests are answered, and
+ * the connection is put on returned for the main thread.
+ */
+static void *
+serve(void *arg)
+{
+    struct worker *w;		/* this thread */
+    struct conn *c;		/* connection being answered */
+    char name[BITMAPD_NAME_MAX+1];	/* bitmap name of a request */
+    size_t len;			/* octets in w->in */
+    size_t pos;			/* next request in w->in */
+    size_t need;		/* octets of the next request */
+    ssize_t got;		/* octets read */
+
+    w = malloc(sizeof(*w));
+    if (w != NULL) {
+	w->values = malloc(BITMAPD_LIST_MAX * sizeof(w->values[0]));
+    }
+    if (w == NULL || w->values == NULL) {
+	fprintf(stderr, "%s: cannot allocate connection buffers\n", program);
+	exit(10);
+    }
+    for (;;) {
+
+	/*
+	 * take the oldest ready connection
+	 */
+	pthread_mutex_lock(&queue_lock);
+	while (ready_head == NULL) {
+	    pthread_cond_wait(&queue_cond, &queue_lock);
+	}
+	c = ready_head;
+	ready_head = c->next;
+	if (ready_head == NULL) {
+	    ready_tail = NULL;
+	}
+	pthread_mutex_unlock(&queue_lock);
+
+	/*
+	 * read what the client has written after the start of a request
+	 * kept from last time
+	 *
+	 * The requests already read are still answered when the client
+	 * has closed the connection.
+	 */
+	w->c = c;
+	w->outlen = 0;
+	memcpy(w->in, c->part, c->partlen);
+	len = c->partlen;
+	do {
+	    got = read(c->fd, w->in + len, sizeof(w->in) - len);
+	} while (got < 0 && errno == EINTR);
+	if (got > 0) {
+	    len += got;
+	} else if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+	    c->eof = 1;
+	}
+
+	/*
+	 * answer each complete request
+	 */
+	for (pos = 0; len - pos >= BITMAPD_REQUEST_LEN; pos += need) {
+	    need = BITMAPD_REQUEST_LEN + w->in[pos+1];
+	    if (len - pos < need) {
+		break;
+	    }
+	    memcpy(name, w->in + pos + BITMAPD_REQUEST_LEN, w->in[pos+1]);
+	    name[w->in[pos+1]] = '\0';
+	    answer(w, w->in + pos, name);
+	}
+	conn_flush(w);
+
+	/*
+	 * keep the start of a request still to come, and hand the
+	 * connection back to the main thread
+	 */
+	c->partlen = len - pos;
+	memcpy(c->part, w->in + pos, c->partlen);
+	pthread_mutex_lock(&queue_lock);
+	c->next = returned;
+	returned = c;
+	pthread_mutex_unlock(&queue_lock);
+	wake_main();
+    }
+    /*NOTREACHED*/
+    return arg;
+}
+
+
+/*
+ * answer - answer a request
+ *
+ * given:
+ *	w	thread answering the request
+ *	req	BITMAPD_REQUEST_LEN octets of the request
+ *	name	bitmap name of the request
+ */
+static void
+answer(struct worker *w, const u_int8_t *req, const char *name)
+{
+    u_int64_t *values = w->values;	/* values of the reply */
+    u_int8_t reply[BITMAPD_REPLY_LEN];	/* reply header */
+    u_int8_t buf[BITMAPD_VALUE_LEN];	/* reply value */
+    const struct bitmap *bm;	/* bitmap of the request */
+    unsigned long long a;	/* arg a */
+    unsigned long long b;	/* arg b */
+    unsigned long long c_arg;	/* arg c */
+    unsigned long nbits;	/* bits in the bitmap */
+    unsigned long lo;		/* first bit of a range */
+    unsigned long hi;		/* bit just beyond a range */
+    unsigned long bit;		/* bit of a value */
+    unsigned long long ones;	/* 1 bits of a range */
+    unsigned long n;		/* reply values */
+    int status;			/* reply status */
+    unsigned long i;
+
+    a = get_u64(req+8);
+    b = get_u64(req+16);
+    c_arg = get_u64(req+24);
+    n = 0;
+    status = BITMAPD_STATUS_OK;
+    pthread_rwlock_rdlock(&map_lock);
+    bm = find_bitmap(name);
+    if (bm == NULL) {
+	status = BITMAPD_STATUS_NO_BITMAP;
+    } else {
+	nbits = bm->maplen * OCTETBITS;
+	switch (req[0]) {
+
+	case BITMAPD_OP_COUNT:
+	case BITMAPD_OP_RANGE:
+
+	    /*
+	     * count the bits of the bits lo to just before hi
+	     */
+	    if (req[0] == BITMAPD_OP_COUNT) {
+		lo = 0;
+		hi = nbits;
+		ones = bm->ones;
+	    } else {
+		lo = bit_ceil(bm, a);
+		hi = bit_end(bm, b);
+		if (hi > nbits) {
+		    hi = nbits;
+		}
+		if (lo > hi) {
+		    lo = hi;
+		}
+		ones = rank_of(bm, hi) - rank_of(bm, lo);
+		a = c_arg;
+	    }
+	    switch (a) {
+	    case 0:
+		values[n++] = (hi - lo) - ones;
+		break;
+	    case 1:
+		values[n++] = ones;
+		break;
+	    case 2:
+		values[n++] = hi - lo;
+		break;
+	    default:
+		status = BITMAPD_STATUS_BAD_ARG;
+		break;
+	    }
+	    break;
+
+	case BITMAPD_OP_MEMBER:
+
+	    /*
+	     * test the bit of the value, if it has one
+	     */
+	    bit = bit_ceil(bm, a);
+	    values[n++] = (bit < nbits && bit < bit_end(bm, a) &&
+			   (bm->map[bit / OCTETBITS] & (1 << (bit % OCTETBITS))) != 0);
+	    break;
+
+	case BITMAPD_OP_NEXT:
+
+	    /*
+	     * find the first set bit of a value >= the value
+	     */
+	    bit = bitscan_next_set(bm->map, bm->maplen, bm->summary, bit_ceil(bm, a));
+	    if (bit != BITSCAN_NONE) {
+		values[n++] = value_of(bm, bit);
+	    }
+	    break;
+
+	case BITMAPD_OP_LIST:
+
+	    /*
+	     * list the set bits of the values lo to hi
+	     */
+	    if (c_arg > BITMAPD_LIST_MAX) {
+		c_arg = BITMAPD_LIST_MAX;
+	    }
+	    lo = bit_ceil(bm, a);
+	    hi = bit_end(bm, b);
+	    if (hi > nbits) {
+		hi = nbits;
+	    }
+	    while (n < c_arg && lo < hi) {
+		bit = bitscan_next_set(bm->map, bm->maplen, bm->summary, lo);
+		if (bit == BITSCAN_NONE || bit >= hi) {
+		    break;
+		}
+		values[n++] = value_of(bm, bit);
+		lo = bit+1;
+	    }
+	    break;
+
+	default:
+	    status = BITMAPD_STATUS_BAD_OP;
+	    break;
+	}
+    }
+    pthread_rwlock_unlock(&map_lock);
+
+    /*
+     * write the reply
+     */
+    if (status != BITMAPD_STATUS_OK) {
+	n = 0;
+	__atomic_add_fetch(&bad_requests, 1, __ATOMIC_RELAXED);
+    }
+    memset(reply, 0, sizeof(reply));
+    reply[0] = status;
+    put_u64(reply+8, n);
+    conn_write(w, reply, sizeof(reply));
+    for (i=0; i < n; ++i) {
+	put_u64(buf, values[i]);
+	conn_write(w, buf, sizeof(buf));
+    }
+    __atomic_add_fetch(&requests, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&values_sent, n, __ATOMIC_RELAXED);
+    return;
+}
+
+
+/*
+ * find_bitmap - find a bitmap by name
+ *
+ * given:
+ *	name	name of the bitmap
+ *
+ * returns:
+ *	bitmap, or NULL ==> no bitmap has the name
+ */
+static struct bitmap *
+find_bitmap(const char *name)
+{
+    int i;
+
+    for (i=0; i < nbitmaps; ++i) {
+	if (strcmp(bitmap[i].name, name) == 0) {
+	    return &bitmap[i];
+	}
+    }
+    return NULL;
+}
+
+
+/*
+ * rank_of - count the 1 bits before a bit
+ *
+ * given:
+ *	bm	bitmap
+ *	bit	bit number, <= 8 * bm->maplen
+ *
+ * returns:
+ *	1 bits of the bitmap before bit
+ *
+ * At most RANK_BLOCK octets are read beyond the rank index entry.
+ */
+static unsigned long long
+rank_of(const struct bitmap *bm, unsigned long bit)
+{
+    unsigned long octet;	/* octet of bit */
+    unsigned long long cnt;	/* 1 bits found */
+    u_int64_t word;		/* 64 bits of the bitmap */
+    unsigned long i;
+
+    octet = bit / OCTETBITS;
+    cnt = bm->rank[octet / RANK_BLOCK];
+    for (i = octet / RANK_BLOCK * RANK_BLOCK; i + sizeof(word) <= octet; i += sizeof(word)) {
+	memcpy(&word, bm->map+i, sizeof(word));
+	cnt += __builtin_popcountll(word);
+    }
+    for (; i < octet; ++i) {
+	cnt += __builtin_popcount(bm->map[i]);
+    }
+    if (bit % OCTETBITS != 0) {
+	cnt += __builtin_popcount(bm->map[octet] & ((1 << (bit % OCTETBITS)) - 1));
+    }
+    return cnt;
+}
+
+
+/*
+ * bit_ceil - first bit of a value >= a value
+ *
+ * given:
+ *	bm	bitmap
+ *	value	value to find
+ *
+ * returns:
+ *	bit number of the smallest value >= value that can be represented,
+ *	or the bits in the bitmap if that value is beyond its end
+ */
+static unsigned long
+bit_ceil(const struct bitmap *bm, unsigned long value)
+{
+    unsigned long nbits = bm->maplen * OCTETBITS;	/* bits in the bitmap */
+    unsigned long d;	/* value less start */
+    unsigned long bit;	/* bit of the value */
+
+    if (value < bm->start) {
+	return 0;
+    }
+    d = value - bm->start;
+    if (wheel) {
+	if (d / WHEEL_MOD >= bm->maplen) {
+	    return nbits;
+	}
+	bit = d / WHEEL_MOD * OCTETBITS + wheel_below[d % WHEEL_MOD];
+    } else {
+	if (d / bm->step >= nbits) {
+	    return nbits;
+	}
+	bit = d / bm->step + (d % bm->step != 0);
+    }
+    return (bit > nbits) ? nbits : bit;
+}
+
+
+/*
+ * bit_end - bit just beyond the bits of values <= a value
+ *
+ * given:
+ *	bm	bitmap
+ *	value	value to find
+ *
+ * returns:
+ *	number of bits whose values are <= value, at most the bits in the
+ *	bitmap
+ *
+ * The bit count saturates before the + 1 of the last bit, so that a
+ * value such as ~0 does not wrap the count around to 0.
+ */
+static unsigned long
+bit_end(const struct bitmap *bm, unsigned long value)
+{
+    unsigned long nbits = bm->maplen * OCTETBITS;	/* bits in the bitmap */
+    unsigned long d;	/* value less start */
+    unsigned long bit;	/* bits of values <= value */
+
+    if (value < bm->start) {
+	return 0;
+    }
+    d = value - bm->start;
+    if (wheel) {
+	if (d / WHEEL_MOD >= bm->maplen) {
+	    return nbits;
+	}
+	bit = d / WHEEL_MOD * OCTETBITS + wheel_below[d % WHEEL_MOD] +
+	      (wheel_bit[d % WHEEL_MOD] >= 0);
+    } else {
+	if (d / bm->step >= nbits) {
+	    return nbits;
+	}
+	bit = d / bm->step + 1;
+    }
+    return (bit > nbits) ? nbits : bit;
+}
+
+
+/*
+ * value_of - value represented by a bit of a bitmap
+ *
+ * given:
+ *	bm	bitmap
+ *	bit	bit offset from the beginning of the bitmap
+ *
+ * returns:
+ *	value represented by bit
+ */
+static unsigned long
+value_of(const struct bitmap *bm, unsigned long bit)
+{
+    if (wheel) {
+	return bm->start + bit / OCTETBITS * WHEEL_MOD + wheel_residue[bit % OCTETBITS];
+    }
+    return bm->start + bit * bm->step;
+}
+
+
+/*
+ * conn_write - buffer octets of a reply
+ *
+ * given:
+ *	w	thread answering the request
+ *	buf	octets to write
+ *	len	octets to write, <= CONN_BUF
+ */
+static void
+conn_write(struct worker *w, const void *buf, size_t len)
+{
+    if (w->outlen + len > sizeof(w->out)) {
+	conn_flush(w);
+    }
+    memcpy(w->out + w->outlen, buf, len);
+    w->outlen += len;
+    return;
+}
+
+
+/*
+ * conn_flush - write the buffered replies
+ *
+ * given:
+ *	w	thread answering the request
+ *
+ * A client that does not read its replies for SEND_WAIT milliseconds,
+ * or a write error, such as when the client has gone away, marks the
+ * connection dead, and the replies are dropped.
+ */
+static void
+conn_flush(struct worker *w)
+{
+    struct conn *c = w->c;	/* connection to write */
+    struct pollfd pfd;		/* connection to wait for */
+    ssize_t put;		/* octets written */
+    size_t done;		/* octets of out written */
+
+    for (done = 0; done < w->outlen && !c->dead; ) {
+	put = write(c->fd, w->out + done, w->outlen - done);
+	if (put < 0 && errno == EINTR) {
+	    continue;
+	}
+	if (put < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+	    pfd.fd = c->fd;
+	    pfd.events = POLLOUT;
+	    if (poll(&pfd, 1, SEND_WAIT) > 0) {
+		continue;
+	    }
+	    c->dead = 1;
+	    break;
+	}
+	if (put <= 0) {
+	    c->dead = 1;
+	    break;
+	}
+	done += put;
+    }
+    w->outlen = 0;
+    return;
+}
+
+
+/*
+ * get_u64 - decode an 8 octet little-endian integer
+ *
+ * given:
+ *	buf		8 octets to decode
+ *
+ * returns:
+ *	decoded integer
+ */
+static unsigned long long
+get_u64(const u_int8_t *buf)
+{
+    unsigned long long value;
+    int i;
+
+    value = 0;
+    for (i=7; i >= 0; --i) {
+	value = (value << 8) | buf[i];
+    }
+    return value;
+}
+
+
+/*
+ * put_u64 - encode an 8 octet little-endian integer
+ *
+ * given:
+ *	buf		8 octets to encode into
+ *	value		integer to encode
+ */
+static void
+put_u64(u_int8_t *buf, unsigned long long value)
+{
+    int i;
+
+    for (i=0; i < 8; ++i) {
+	buf[i] = value & 0xff;
+	value >>= 8;
+    }
+    return;
+}
@@ -0,0 +1,109 @@
+/*
+ * bitmapd - request protocol of the bitmapd daemon and bitmapc client
+ *
+ * A client connects to the Unix domain socket of bitmapd and writes
+ * requests.  Each request is answered by one reply, in the order the
+ * requests were written, so a client may write several requests before
+ * it reads their replies.  All integers are little-endian.  A request is:
+ *
+ *	1 octet:	op, one of the BITMAPD_OP_ values below
+ *	1 octet:	length of the bitmap name
+ *	6 octets:	0
+ *	8 octets:	arg a
+ *	8 octets:	arg b
+ *	8 octets:	arg c
+ *	name:		name of the bitmap, as given to bitmapd
+ *
+ * A reply is:
+ *
+ *	1 octet:	status, one of the BITMAPD_STATUS_ values below
+ *	7 octets:	0
+ *	8 octets:	number of values that follow
+ *	8 octets per value
+ *
+ * A reply whose status is not BITMAPD_STATUS_OK has no values.  Values
+ * are bitmap values, i.e., start + step*bit or the wheel equivalent, not
+ * bit numbers.  The ops are:
+ *
+ *	COUNT	a: 0 ==> count 0 bits, 1 ==> count 1 bits, 2 ==> count bits
+ *		reply: 1 value, the count over the whole bitmap
+ *
+ *	RANGE	a: lo value, b: hi value, c: type of bits as for COUNT
+ *		reply: 1 value, the count over the bits of values lo to hi
+ *
+ *	MEMBER	a: value
+ *		reply: 1 value, 1 ==> the bit of value is set, else 0
+ *
+ *	NEXT	a: value
+ *		reply: 1 value, the smallest set value >= a, or no values
+ *		when there is none
+ *
+ *	LIST	a: lo value, b: hi value, c: max values
+ *		reply: the set values from lo to hi in increasing order,
+ *		at most c and at most BITMAPD_LIST_MAX of them.  A reply
+ *		that is full may have more set values beyond its last one.
+ *
+ * As with popcnt, only the bits within the length of the bitmap file
+ * are counted.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#if !defined(INCLUDE_BITMAPD_H)
+#define INCLUDE_BITMAPD_H
+
+
+/*
+ * request and reply layout
+ */
+#define BITMAPD_REQUEST_LEN (32)	/* octets of a request before the name */
+#define BITMAPD_REPLY_LEN (16)		/* octets of a reply before the values */
+#define BITMAPD_VALUE_LEN (8)		/* octets per reply value */
+#define BITMAPD_NAME_MAX (255)		/* max octets of a bitmap name */
+#define BITMAPD_LIST_MAX (65536)	/* max values of a LIST reply */
+
+/*
+ * request ops
+ */
+#define BITMAPD_OP_COUNT (1)		/* count bits of the bitmap */
+#define BITMAPD_OP_RANGE (2)		/* count bits of a range of values */
+#define BITMAPD_OP_MEMBER (3)		/* is a value set */
+#define BITMAPD_OP_NEXT (4)		/* smallest set value >= a value */
+#define BITMAPD_OP_LIST (5)		/* set values of a range of values */
+
+/*
+ * reply status
+ */
+#define BITMAPD_STATUS_OK (0)		/* answered */
+#define BITMAPD_STATUS_NO_BITMAP (1)	/* no bitmap has the name */
+#define BITMAPD_STATUS_BAD_OP (2)	/* unknown op */
+#define BITMAPD_STATUS_BAD_ARG (3)	/* invalid arg */
+
+
+#endif /* INCLUDE_BITMAPD_H */
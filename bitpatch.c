@@ -0,0 +1,589 @@
+/*
+ * bitpatch - apply a bitdiff delta to a bitmap file in place
+ *
+ * We will read a delta, as written by bitdiff, from stdin and apply it
+ * to the old version of a bitmap file, turning it into the new version
+ * in place.  Only the words recorded in the delta are changed, and the
+ * file is then cut or extended to the length of the new version.  The
+ * delta format is described in bitdelta.h.
+ *
+ * The bitmap file is never made shorter in place, as that kills any
+ * process that has it mapped, such as bitmapd.  When the new version is
+ * shorter, it is written to a new file that is renamed over the bitmap
+ * file.
+ *
+ * The bitmap file is mapped into memory and the delta is read a buffer
+ * at a time, so neither has to fit in memory.  A bitmap file that does
+ * not exist is created when the old version of the delta is empty.
+ *
+ * The length and checksum of the bitmap file must match those of the
+ * old version recorded in the delta, or the bitmap file is left
+ * unchanged.  So a delta made from a different old version, or one that
+ * was already applied, is refused.  After patching, the checksum of the
+ * bitmap file is checked against that of the new version.  A delta that
+ * is truncated or malformed part way through leaves the bitmap file
+ * partly patched, so patch a copy when that matters.
+ *
+ * With -s, counters of delta octets read, records read and words
+ * patched, along with the wall clock and CPU time spent reading and
+ * patching, are written as JSON on stderr at exit.  The same report is
+ * written when SIGUSR1 is received.
+ *
+ * With -p, the CPU cycles, instructions, branch-misses and last level
+ * cache misses of the main loop, along with cycles per delta octet and
+ * instructions per cycle, are written as JSON on stderr at exit.  This
+ * requires Linux hardware performance counters.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "stats.h"
+#include "perfctr.h"
+#include "bitdelta.h"
+
+
+/*
+ * official version
+ */
+#define VERSION "1.0.0 2026-10-19"          /* format: major.minor YYYY-MM-DD */
+
+
+/*
+ * useful defines
+ */
+#define CHUNK (65536)	/* delta octets read per buffer, multiple of DELTA_WORD */
+
+
+/*
+ * usage message
+ */
+static const char * const usage =
+  "usage: %s [-h] [-V] [-s] [-p] bitmap\n"
+        "\n"
+        "    -h            print help message and exit\n"
+        "    -V            print version string and exit\n"
+        "    -s            write stats as JSON on stderr at exit and on SIGUSR1\n"
+        "    -p            write hardware counters of the main loop as JSON on stderr\n"
+        "\n"
+        "    bitmap        bitmap file to patch\n"
+        "\n"
+        "    The delta, as written by bitdiff, is read from stdin\n"
+        "\n"
+        "Exit codes:\n"
+        "    0         all OK\n"
+        "    2         -h and help string printed or -V and version string printed\n"
+        "    3         command line error\n"
+        "    4         cannot open, map or resize the bitmap file\n"
+        "    5         not a delta, a delta of a different old version, or the\n"
+        "              patched bitmap does not match the new version\n"
+        "    6         read error or truncated delta\n"
+        " >= 10        internal error\n"
+        "\n"
+        "%s version: %s\n";
+
+
+/*
+ * static declarations
+ */
+static char *program = NULL;    /* our name */
+static char *prog = NULL;       /* basename of program */
+static const char * const version = VERSION;
+
+/*
+ * delta read buffer, one word per element
+ */
+static u_int64_t buffer[CHUNK / DELTA_WORD];
+
+/*
+ * stats counters and phases, see -s
+ */
+static unsigned long long octets_read = 0;	/* delta octets read */
+static unsigned long long records_read = 0;	/* runs of changed words read */
+static unsigned long long words_patched = 0;	/* bitmap words changed */
+
+
+/*
+ * static functions
+ */
+static void read_delta(void *buf, unsigned long len);
+static unsigned long long sum_bitmap(int fd, const char *filename,
+				     unsigned long long len);
+static void shrink_bitmap(int fd, const char *filename, const u_int8_t *map,
+			  unsigned long long len);
+static unsigned long long get_u64(const u_int8_t *buf);
+static unsigned long long get_varint(void);
+
+
+int
+main(int argc, char *argv[])
+{
+    char *mapname;		/* bitmap file name */
+    int mapfd;			/* bitmap file descriptor */
+    u_int8_t *map = NULL;	/* mapped bitmap file, NULL ==> none */
+    unsigned long long maplen;	/* octets mapped */
+    struct stat sbuf;		/* bitmap file status */
+    u_int8_t header[DELTA_HEADER_LEN];	/* delta header */
+    unsigned long long oldlen;	/* octets in the old version */
+    unsigned long long newlen;	/* octets in the new version */
+    unsigned long long oldsum;	/* checksum of the old version */
+    unsigned long long newsum;	/* checksum of the new version */
+    unsigned long long sum;	/* checksum of the patched bitmap */
+    unsigned long long maxwords;	/* words in the new version */
+    unsigned long long word;	/* next word of the bitmap to patch */
+    unsigned long long skip;	/* words to skip before a record */
+    unsigned long long count;	/* words left in a record */
+    unsigned long n;		/* words in the buffer */
+    unsigned long w;		/* word in the buffer */
+    unsigned long long off;	/* octet offset in the bitmap */
+    u_int64_t x;		/* bitmap word */
+    void *addr;			/* mapped address */
+    int read_phase;		/* reading the delta */
+    int patch_phase;		/* patching the bitmap */
+    int i;
+
+    /*
+     * parse args
+     */
+    program = argv[0];
+    prog = rindex(program, '/');
+    if (prog == NULL) {
+        prog = program;
+    } else {
+        ++prog;
+    }
+    while ((i = getopt(argc, argv, ":hVsp")) != -1) {
+	switch (i) {
+
+        case 'h':                   /* -h - print help message and exit */
+	    fprintf(stderr, usage, program, prog, version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 'V':                   /* -V - print version string and exit */
+            (void) printf("%s\n", version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 's':                   /* -s - write stats */
+	    stats_setup(prog);
+	    break;
+
+	case 'p':                   /* -p - write hardware counters */
+	    perfctr_setup(prog);
+	    break;
+
+	case ':':
+            (void) fprintf(stderr, "%s: ERROR: requires an argument -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        case '?':
+            (void) fprintf(stderr, "%s: ERROR: illegal option -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        default:
+            fprintf(stderr, "%s: ERROR: invalid -flag\n", program);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+        }
+    }
+    /* skip over command line options */
+    argv += optind;
+    argc -= optind;
+    /* check the arg count */
+    if (argc != 1) {
+        fprintf(stderr, "%s: ERROR: expected 1 arg, found: %d\n", program, argc);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+
+    /*
+     * setup and initialize
+     */
+    stats_counter("octets_read", &octets_read);
+    stats_counter("records_read", &records_read);
+    stats_counter("words_patched", &words_patched);
+    read_phase = stats_phase("read");
+    patch_phase = stats_phase("patch");
+
+    /*
+     * read the header and check that the delta applies to the bitmap
+     *
+     * A missing bitmap file is only created for a delta from an empty
+     * old version.  The bitmap is read to find its checksum before
+     * anything is written to it.
+     */
+    stats_switch(read_phase);
+    read_delta(header, DELTA_HEADER_LEN);
+    if (memcmp(header, DELTA_MAGIC, DELTA_MAGIC_LEN) != 0) {
+	fprintf(stderr, "%s: stdin is not a bitmap delta\n", program);
+	exit(5);
+    }
+    oldlen = get_u64(header + DELTA_MAGIC_LEN);
+    newlen = get_u64(header + DELTA_MAGIC_LEN + 8);
+    oldsum = get_u64(header + DELTA_MAGIC_LEN + 16);
+    newsum = get_u64(header + DELTA_MAGIC_LEN + 24);
+    mapname = argv[0];
+    mapfd = open(mapname, (oldlen == 0) ? O_RDWR|O_CREAT : O_RDWR, 0644);
+    if (mapfd < 0 || fstat(mapfd, &sbuf) < 0) {
+	fprintf(stderr, "%s: cannot open %s: %s\n", program, mapname, strerror(errno));
+	exit(4);
+    }
+    if ((unsigned long long)sbuf.st_size != oldlen) {
+	fprintf(stderr, "%s: %s is %lld octets, delta is from a version of %llu octets\n",
+		program, mapname, (long long)sbuf.st_size, oldlen);
+	exit(5);
+    }
+    if (sum_bitmap(mapfd, mapname, oldlen) != oldsum) {
+	fprintf(stderr, "%s: %s does not match the old version of the delta\n",
+		program, mapname);
+	exit(5);
+    }
+    maxwords = (newlen + DELTA_WORD - 1) / DELTA_WORD;
+
+    /*
+     * map the bitmap, long enough for both versions
+     */
+    maplen = (newlen > oldlen) ? newlen : oldlen;
+    if (maplen != oldlen && ftruncate(mapfd, maplen) < 0) {
+	fprintf(stderr, "%s: cannot resize %s to %llu octets: %s\n",
+		program, mapname, maplen, strerror(errno));
+	exit(4);
+    }
+    if (maplen > 0) {
+	addr = mmap(NULL, maplen, PROT_READ|PROT_WRITE, MAP_SHARED, mapfd, 0);
+	if (addr == MAP_FAILED) {
+	    fprintf(stderr, "%s: cannot mmap %s: %s\n", program, mapname, strerror(errno));
+	    exit(4);
+	}
+	map = addr;
+    }
+    perfctr_start();
+
+    /*
+     * apply each record
+     */
+    word = 0;
+    for (;;) {
+	if (stats_wanted) {
+	    stats_report(0);
+	}
+	stats_switch(read_phase);
+	skip = get_varint();
+	count = get_varint();
+	if (count == 0) {
+	    if (skip != 0) {
+		fprintf(stderr, "%s: malformed delta: record of 0 words\n", program);
+		exit(5);
+	    }
+	    break;	/* end of delta */
+	}
+	++records_read;
+	if (skip > maxwords - word || count > maxwords - word - skip) {
+	    fprintf(stderr, "%s: malformed delta: record beyond the end of the bitmap\n",
+		    program);
+	    exit(5);
+	}
+	word += skip;
+
+	/*
+	 * XOR the words of the record into the bitmap, a buffer at a time
+	 */
+	while (count > 0) {
+	    stats_switch(read_phase);
+	    n = (count < CHUNK / DELTA_WORD) ? count : CHUNK / DELTA_WORD;
+	    read_delta(buffer, n * DELTA_WORD);
+	    stats_bytes(read_phase, n * DELTA_WORD);
+	    stats_switch(patch_phase);
+	    stats_bytes(patch_phase, n * DELTA_WORD);
+	    for (w = 0; w < n; ++w) {
+		off = (word + w) * DELTA_WORD;
+		if (off + DELTA_WORD <= maplen) {
+		    memcpy(&x, map + off, DELTA_WORD);
+		    x ^= buffer[w];
+		    memcpy(map + off, &x, DELTA_WORD);
+		} else {
+		    /* last word of the bitmap is partial */
+		    for (i=0; off + i < maplen; ++i) {
+			map[off + i] ^= ((u_int8_t *)&buffer[w])[i];
+		    }
+		}
+	    }
+	    words_patched += n;
+	    word += n;
+	    count -= n;
+	}
+    }
+    if (getchar() != EOF) {
+	fprintf(stderr, "%s: malformed delta: data after the end\n", program);
+	exit(5);
+    }
+
+    /*
+     * cut the bitmap to the length of the new version and unmap it, then
+     * check the patched bitmap against the new version
+     */
+    stats_switch(patch_phase);
+    sum = delta_sum(DELTA_SUM_INIT, map, newlen);
+    if (newlen < maplen) {
+	shrink_bitmap(mapfd, mapname, map, newlen);
+    }
+    if (map != NULL && munmap(map, maplen) < 0) {
+	fprintf(stderr, "%s: cannot unmap %s: %s\n", program, mapname, strerror(errno));
+	exit(4);
+    }
+    if (close(mapfd) < 0) {
+	fprintf(stderr, "%s: cannot close %s: %s\n", program, mapname, strerror(errno));
+	exit(4);
+    }
+    if (sum != newsum) {
+	fprintf(stderr, "%s: patched %s does not match the new version of the delta\n",
+		program, mapname);
+	exit(5);
+    }
+
+    /*
+     * report hardware counters if -p
+     */
+    perfctr_stop(octets_read);
+
+    /*
+     * report stats if -s
+     */
+    if (stats_on) {
+	stats_switch(-1);
+	stats_report(1);
+    }
+
+    /*
+     * All done!
+     *
+     *	-- Jessica Noll, 1985
+     */
+    exit(0);
+}
+
+
+/*
+ * read_delta - read octets of the delta from stdin
+ *
+ * given:
+ *	buf		where to read
+ *	len		octets to read
+ *
+ * A delta that ends early is reported as a read error.
+ */
+static void
+read_delta(void *buf, unsigned long len)
+{
+    clearerr(stdin);
+    if (fread(buf, 1, len, stdin) != len) {
+	if (ferror(stdin)) {
+	    fprintf(stderr, "%s: read error: %s\n", program, strerror(errno));
+	} else {
+	    fprintf(stderr, "%s: delta ends early\n", program);
+	}
+	exit(6);
+    }
+    octets_read += len;
+    return;
+}
+
+
+/*
+ * sum_bitmap - find the checksum of the bitmap file
+ *
+ * given:
+ *	fd		open bitmap file, at its start
+ *	filename	name of the bitmap file
+ *	len		octets in the bitmap file
+ *
+ * returns:
+ *	checksum of the bitmap file, with fd at its end
+ */
+static unsigned long long
+sum_bitmap(int fd, const char *filename, unsigned long long len)
+{
+    unsigned long long sum;	/* checksum so far */
+    unsigned long long pos;	/* octet offset of the buffer */
+    unsigned long cnt;		/* octets to read into the buffer */
+    unsigned long got;		/* octets read into the buffer */
+    ssize_t n;			/* octets read by read(), or < 0 */
+
+    sum = DELTA_SUM_INIT;
+    for (pos = 0; pos < len; pos += cnt) {
+	cnt = (len - pos < CHUNK) ? len - pos : CHUNK;
+	for (got = 0; got < cnt; got += n) {
+	    n = read(fd, (u_int8_t *)buffer + got, cnt - got);
+	    if (n <= 0) {
+		if (n < 0) {
+		    fprintf(stderr, "%s: cannot read %s: %s\n",
+			    program, filename, strerror(errno));
+		} else {
+		    fprintf(stderr, "%s: %s became shorter while being read\n",
+			    program, filename);
+		}
+		exit(4);
+	    }
+	}
+	sum = delta_sum(sum, (u_int8_t *)buffer, cnt);
+    }
+    return sum;
+}
+
+
+/*
+ * shrink_bitmap - replace the bitmap file with its first len octets
+ *
+ * given:
+ *	fd		open bitmap file
+ *	filename	name of the bitmap file
+ *	map		mapped bitmap file
+ *	len		octets to keep, < the octets in the bitmap file
+ *
+ * The bitmap file is not truncated in place, as a process that has it
+ * mapped, such as bitmapd, is killed by SIGBUS when it touches a page
+ * beyond the new end.  Instead the octets kept are written to a new file
+ * in the same directory, which is renamed over the bitmap file.
+ */
+static void
+shrink_bitmap(int fd, const char *filename, const u_int8_t *map,
+	      unsigned long long len)
+{
+    struct stat sbuf;		/* old bitmap file status */
+    char *tmpname;		/* new bitmap file name */
+    int tmpfd;			/* new bitmap file descriptor */
+    unsigned long long off;	/* octets written */
+    ssize_t n;			/* octets written by write(), or < 0 */
+
+    tmpname = malloc(strlen(filename) + sizeof(".XXXXXX"));
+    if (tmpname == NULL) {
+	fprintf(stderr, "%s: cannot allocate file name\n", program);
+	exit(10);
+    }
+    sprintf(tmpname, "%s.XXXXXX", filename);
+    tmpfd = mkstemp(tmpname);
+    if (tmpfd < 0 || fstat(fd, &sbuf) < 0 || fchmod(tmpfd, sbuf.st_mode & 07777) < 0) {
+	fprintf(stderr, "%s: cannot create %s: %s\n", program, tmpname, strerror(errno));
+	exit(4);
+    }
+    for (off = 0; off < len; off += n) {
+	n = write(tmpfd, map + off, len - off);
+	if (n < 0) {
+	    if (errno == EINTR) {
+		n = 0;
+		continue;
+	    }
+	    fprintf(stderr, "%s: cannot write %s: %s\n", program, tmpname, strerror(errno));
+	    (void) unlink(tmpname);
+	    exit(4);
+	}
+    }
+    if (close(tmpfd) < 0 || rename(tmpname, filename) < 0) {
+	fprintf(stderr, "%s: cannot rename %s to %s: %s\n",
+		program, tmpname, filename, strerror(errno));
+	(void) unlink(tmpname);
+	exit(4);
+    }
+    free(tmpname);
+    return;
+}
+
+
+/*
+ * get_u64 - decode an 8 octet little-endian integer
+ *
+ * given:
+ *	buf		8 octets to decode
+ *
+ * returns:
+ *	decoded integer
+ */
+static unsigned long long
+get_u64(const u_int8_t *buf)
+{
+    unsigned long long value;
+    int i;
+
+    value = 0;
+    for (i=7; i >= 0; --i) {
+	value = (value << 8) | buf[i];
+    }
+    return value;
+}
+
+
+/*
+ * get_varint - read a varint of the delta from stdin
+ *
+ * returns:
+ *	decoded integer
+ */
+static unsigned long long
+get_varint(void)
+{
+    unsigned long long value;	/* decoded integer */
+    int c;			/* octet read, or EOF */
+    int i;
+
+    value = 0;
+    for (i=0; i < DELTA_VARINT_MAX; ++i) {
+	c = getchar();
+	if (c == EOF) {
+	    if (ferror(stdin)) {
+		fprintf(stderr, "%s: read error: %s\n", program, strerror(errno));
+	    } else {
+		fprintf(stderr, "%s: delta ends early\n", program);
+	    }
+	    exit(6);
+	}
+	++octets_read;
+	value |= (unsigned long long)(c & 0x7f) << (7*i);
+	if ((c & 0x80) == 0) {
+	    return value;
+	}
+    }
+    fprintf(stderr, "%s: malformed delta: varint too long\n", program);
+    exit(5);
+}
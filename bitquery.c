@@ -0,0 +1,753 @@
+/*
+ * bitquery - answer membership and next/prev queries against a bitmap
+ *
+ * We will map a bitmap file into memory, read values from stdin, and
+ * for each value write 1 if its bit in the bitmap is set, or 0 if it
+ * is not.  Answers are written to stdout one per line, in input order.
+ *
+ * With -N, for each value we write the smallest value >= it whose bit
+ * is set instead.  With -P, for each value we write the largest value
+ * <= it whose bit is set instead.  When there is no such value, we
+ * write "none".  These queries start at the octet of the value and test
+ * the bitmap a 64 bit word at a time.  With -S summary as well, long
+ * empty stretches of the bitmap are skipped a 4 KiB block at a time
+ * using a summary bitmap with one bit per nonzero block (see bitscan.h).
+ * The summary file is built and written when it is missing or was not
+ * saved for a bitmap file of the same length and modification time.
+ *
+ * The bitmap represents values as written by bitset, i.e., the bit of
+ * octet 'x' bit 'y' represents start + step*(x*8 + y), so the value 'v'
+ * is represented by:
+ *
+ *	t = (v - start) / step
+ *	x = t / 8
+ *	y = t % 8
+ *
+ * provided that (v - start) % step == 0.  With -w, the bitmap uses the
+ * mod 30 wheel layout (see wheel.h) and step must be 30.  Values that
+ * are < start, that cannot be represented in the bitmap, or that are
+ * beyond the end of the bitmap file are not set, and are answered 0.
+ *
+ * Input values are read one per line.  With -b, input values are read
+ * as raw little-endian 64 bit integers instead.  With -B, answers are
+ * written as one octet, 0 or 1, per value instead of one per line.
+ * -B is only for membership queries.  A malformed input line is reported
+ * on stderr and answered 0 (or "none"), so that the answers stay in
+ * input order.
+ *
+ * Values are answered in batches of BATCH values.  The octets of a
+ * batch are prefetched before any of them are tested, so that the
+ * cache misses and page faults of a batch of random lookups overlap
+ * rather than being paid one at a time.
+ *
+ * With -s, counters of values read, found, and malformed, along with
+ * the wall clock and CPU time spent reading and looking up values, are
+ * written as JSON on stderr at exit.  The same report is written when
+ * SIGUSR1 is received.
+ *
+ * With -p, the CPU cycles, instructions, branch-misses and last level
+ * cache misses of the lookup loop, along with cycles per input octet and
+ * instructions per cycle, are written as JSON on stderr at exit.  This
+ * requires Linux hardware performance counters.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <sys/errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "stats.h"
+#include "perfctr.h"
+#include "wheel.h"
+#include "bitscan.h"
+
+
+/*
+ * official version
+ */
+#define VERSION "1.1.0 2026-10-19"          /* format: major.minor YYYY-MM-DD */
+
+
+/*
+ * useful defines
+ */
+#define MAXLINE (1+19+1)	/* signed 19 digit value + newline */
+#define OCTETBITS (8)	/* 8 bits per octet */
+#define WORDOCTETS (8)	/* octets per 64 bit binary input value */
+#define BATCH (512)	/* values looked up per batch */
+#define NOTSET (-1)	/* octet of a value that cannot be set */
+
+/*
+ * what we will query
+ */
+#define QUERY_MEMBER (0)	/* is the value set */
+#define QUERY_NEXT (1)		/* smallest set value >= value */
+#define QUERY_PREV (2)		/* largest set value <= value */
+
+
+/*
+ * usage message
+ */
+static const char * const usage =
+  "usage: %s [-h] [-V] [-s] [-p] [-w] [-b] [-B | -N | -P [-S summary]] bitmap start step\n"
+        "\n"
+        "    -h            print help message and exit\n"
+        "    -V            print version string and exit\n"
+        "    -s            write stats as JSON on stderr at exit and on SIGUSR1\n"
+        "    -p            write hardware counters of the main loop as JSON on stderr\n"
+        "    -w            use the mod 30 wheel layout (step must be 30)\n"
+        "    -b            read values as raw little-endian 64 bit integers\n"
+        "    -B            write answers as raw octets instead of lines\n"
+        "    -N            write the next set value >= each value\n"
+        "    -P            write the previous set value <= each value\n"
+        "    -S summary    skip empty 4 KiB blocks using this summary file\n"
+        "\n"
+        "    bitmap        bitmap file\n"
+        "    start         starting bitmap value\n"
+        "    step          step values between bits\n"
+        "\n"
+        "Exit codes:\n"
+        "    0         all OK\n"
+        "    2         -h and help string printed or -V and version string printed\n"
+        "    3         command line error\n"
+        "    4         cannot open or map the bitmap file\n"
+        " >= 10        internal error\n"
+        "\n"
+        "%s version: %s\n";
+
+
+/*
+ * static declarations
+ */
+static char *program = NULL;    /* our name */
+static char *prog = NULL;       /* basename of program */
+static const char * const version = VERSION;
+
+/*
+ * bitmap
+ */
+static const u_int8_t *map = NULL;	/* mapped bitmap file */
+static unsigned long maplen = 0;	/* octets in the bitmap file */
+static struct stat mapstat;		/* status of bitmap file */
+static u_int8_t *summary = NULL;	/* summary of bitmap, NULL ==> none */
+static unsigned long start;		/* starting bitmap value */
+static unsigned long step;		/* bitmap increment value */
+static int wheel = 0;			/* 1 ==> -w mod 30 wheel layout */
+
+/*
+ * current batch
+ */
+static unsigned long batch_value[BATCH];	/* values of the batch */
+static long batch_octet[BATCH];		/* octet of value, or NOTSET */
+static u_int8_t batch_mask[BATCH];	/* bit of value within its octet */
+static u_int8_t batch_answer[BATCH];	/* 1 ==> value is set */
+static u_int8_t batch_bad[BATCH];	/* 1 ==> malformed input value */
+
+/*
+ * stats counters and phases, see -s
+ */
+static unsigned long long values_read = 0;	/* values looked up */
+static unsigned long long values_found = 0;	/* values whose bit is set */
+static unsigned long long ignored_invalid = 0;	/* malformed input lines */
+
+
+/*
+ * static functions
+ */
+static void map_bitmap(const char *filename);
+static int read_text(unsigned long long *inbytes);
+static int read_binary(unsigned long long *inbytes);
+static void locate(int n);
+static void write_answers(int n, int raw);
+static void write_nearest(int n, int query);
+static unsigned long value_of(unsigned long bit);
+
+
+int
+main(int argc, char *argv[])
+{
+    int n;			/* values in the current batch */
+    int binary = 0;		/* 1 ==> -b binary input */
+    int raw = 0;		/* 1 ==> -B raw output */
+    int query = QUERY_MEMBER;	/* what we will query */
+    char *sumfile = NULL;	/* -S summary file, NULL ==> none */
+    unsigned long long inbytes;	/* input octets read */
+    unsigned long long batchbytes;	/* input octets read before this batch */
+    int read_phase;		/* reading values */
+    int lookup_phase;		/* looking up values */
+    int i;
+
+    /*
+     * parse args
+     */
+    program = argv[0];
+    prog = rindex(program, '/');
+    if (prog == NULL) {
+        prog = program;
+    } else {
+        ++prog;
+    }
+    while ((i = getopt(argc, argv, ":hVspwbBNPS:")) != -1) {
+	switch (i) {
+
+        case 'h':                   /* -h - print help message and exit */
+	    fprintf(stderr, usage, program, prog, version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 'V':                   /* -V - print version string and exit */
+            (void) printf("%s\n", version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 's':                   /* -s - write stats */
+	    stats_setup(prog);
+	    break;
+
+	case 'p':                   /* -p - write hardware counters */
+	    perfctr_setup(prog);
+	    break;
+
+	case 'w':                   /* -w - mod 30 wheel layout */
+	    wheel = 1;
+	    break;
+
+	case 'b':                   /* -b - binary input */
+	    binary = 1;
+	    break;
+
+	case 'B':                   /* -B - raw output */
+	    raw = 1;
+	    break;
+
+	case 'N':                   /* -N - next set value */
+	    query = QUERY_NEXT;
+	    break;
+
+	case 'P':                   /* -P - previous set value */
+	    query = QUERY_PREV;
+	    break;
+
+	case 'S':                   /* -S summary - summary file */
+	    sumfile = optarg;
+	    break;
+
+	case ':':
+            (void) fprintf(stderr, "%s: ERROR: requires an argument -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        case '?':
+            (void) fprintf(stderr, "%s: ERROR: illegal option -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        default:
+            fprintf(stderr, "%s: ERROR: invalid -flag\n", program);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+        }
+    }
+    /* skip over command line options */
+    argv += optind;
+    argc -= optind;
+    /* check the arg count */
+    if (argc != 3) {
+        fprintf(stderr, "%s: ERROR: expected 3 args, found: %d\n", program, argc);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+
+    /* parse start */
+    errno = 0;
+    start = strtoll(argv[1], NULL, 0);
+    if (errno == ERANGE) {
+	fprintf(stderr, "%s: failed to parse start value: %s\n", program, argv[1]);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+
+    /* parse step */
+    errno = 0;
+    step = strtoll(argv[2], NULL, 0);
+    if (errno == ERANGE) {
+	fprintf(stderr, "%s: failed to parse step value: %s\n", program, argv[2]);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if ((long)step <= 0) {
+	fprintf(stderr, "%s: step value must be > 0: %s\n", program, argv[2]);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if (wheel && (step != WHEEL_MOD || (long)start % WHEEL_MOD != 0)) {
+	fprintf(stderr, "%s: with -w, step must be %d and start a multiple of %d\n",
+		program, WHEEL_MOD, WHEEL_MOD);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+
+    if (raw && query != QUERY_MEMBER) {
+	fprintf(stderr, "%s: -B conflicts with -N and -P\n", program);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if (sumfile != NULL && query == QUERY_MEMBER) {
+	fprintf(stderr, "%s: -S requires -N or -P\n", program);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+
+    /*
+     * setup and initialize
+     */
+    map_bitmap(argv[0]);
+    if (sumfile != NULL) {
+	summary = bitscan_load_summary(prog, sumfile, map, maplen, &mapstat);
+    }
+    stats_counter("values_read", &values_read);
+    stats_counter("values_found", &values_found);
+    stats_counter("ignored_invalid", &ignored_invalid);
+    read_phase = stats_phase("read");
+    lookup_phase = stats_phase("lookup");
+    inbytes = 0;
+    perfctr_start();
+
+    /*
+     * answer batches of values until EOF
+     */
+    do {
+
+	/*
+	 * read a batch
+	 */
+	if (stats_wanted) {
+	    stats_report(0);
+	}
+	stats_switch(read_phase);
+	batchbytes = inbytes;
+	if (binary) {
+	    n = read_binary(&inbytes);
+	} else {
+	    n = read_text(&inbytes);
+	}
+	values_read += n;
+	stats_bytes(read_phase, inbytes - batchbytes);
+
+	/*
+	 * look up the batch and write the answers in input order
+	 */
+	stats_switch(lookup_phase);
+	stats_bytes(lookup_phase, inbytes - batchbytes);
+	if (query != QUERY_MEMBER) {
+	    write_nearest(n, query);
+	    continue;
+	}
+	locate(n);
+	for (i=0; i < n; ++i) {
+	    if (batch_octet[i] != NOTSET &&
+	        (map[batch_octet[i]] & batch_mask[i]) != 0) {
+		batch_answer[i] = 1;
+		++values_found;
+	    } else {
+		batch_answer[i] = 0;
+	    }
+	}
+	write_answers(n, raw);
+
+    } while (n == BATCH);
+
+    /*
+     * report hardware counters if -p
+     */
+    fflush(stdout);
+    perfctr_stop(inbytes);
+
+    /*
+     * report stats if -s
+     */
+    if (stats_on) {
+	stats_switch(lookup_phase);
+	fflush(stdout);
+	stats_switch(-1);
+	stats_report(1);
+    }
+
+    /*
+     * All done!
+     *
+     *	-- Jessica Noll, 1985
+     */
+    exit(0);
+}
+
+
+/*
+ * map_bitmap - map a bitmap file into memory
+ *
+ * given:
+ *	filename	bitmap file to map
+ *
+ * An empty bitmap file is not mapped; all values are then answered 0.
+ * Lookups touch octets at random, so we ask the kernel not to read ahead.
+ */
+static void
+map_bitmap(const char *filename)
+{
+    struct stat sbuf;	/* bitmap file status */
+    void *addr;		/* mapped address */
+    int fd;		/* bitmap file descriptor */
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+	fprintf(stderr, "%s: cannot open %s: %s\n", program, filename, strerror(errno));
+	exit(4);
+    }
+    if (fstat(fd, &sbuf) < 0) {
+	fprintf(stderr, "%s: cannot stat %s: %s\n", program, filename, strerror(errno));
+	exit(4);
+    }
+    maplen = sbuf.st_size;
+    mapstat = sbuf;
+    if (maplen > 0) {
+	addr = mmap(NULL, maplen, PROT_READ, MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED) {
+	    fprintf(stderr, "%s: cannot mmap %s: %s\n", program, filename, strerror(errno));
+	    exit(4);
+	}
+#if defined(MADV_RANDOM)
+	(void) madvise(addr, maplen, MADV_RANDOM);
+#endif
+	map = addr;
+    }
+    (void) close(fd);
+    return;
+}
+
+
+/*
+ * read_text - read a batch of values, one per line
+ *
+ * given:
+ *	inbytes		add the input octets read to this count
+ *
+ * returns:
+ *	number of values read into batch_value[], < BATCH ==> EOF
+ *
+ * A malformed line is reported on stderr and marked in batch_bad[].
+ */
+static int
+read_text(unsigned long long *inbytes)
+{
+    static char inbuf[MAXLINE+1];	/* max input line + NUL byte */
+    static long line = 0;		/* input line number */
+    char *p;	/* char check pointer */
+    int n;
+
+    for (n=0; n < BATCH; ++n) {
+
+	/*
+	 * read a line
+	 */
+	clearerr(stdin);
+	if (fgets(inbuf, MAXLINE+1, stdin) == NULL) {
+	    if (ferror(stdin)) {
+		fprintf(stderr, "%s: read error: %s\n", program, strerror(errno));
+		exit(6);
+	    }
+	    break;	/* EOF found */
+	}
+	++line;
+
+	/*
+	 * input must be an integer (with a possible leading -) followed by
+	 * a newline, or by EOF on the last line
+	 */
+	p = ((inbuf[0] == '-') ? inbuf+1 : inbuf);
+	while (*p != '\0' && isdigit(*p)) {
+	    ++p;
+	}
+	*inbytes += p - inbuf;
+	if (p == inbuf || !isdigit(*(p-1)) || (*p != '\n' && *p != '\0') ||
+	    (*p == '\0' && !feof(stdin))) {
+	    fprintf(stderr, "%s: line %ld: invalid value, answering 0\n", program, line);
+	    ++ignored_invalid;
+	    /* skip the rest of a line that is too long */
+	    while (strchr(inbuf, '\n') == NULL) {
+		if (fgets(inbuf, MAXLINE+1, stdin) == NULL) {
+		    break;
+		}
+	    }
+	    batch_bad[n] = 1;
+	    continue;
+	}
+	if (*p == '\n') {
+	    ++*inbytes;
+	}
+
+	/*
+	 * convert the line
+	 */
+	batch_bad[n] = 0;
+	errno = 0;
+	batch_value[n] = strtoll(inbuf, NULL, 0);
+	if (errno == ERANGE) {
+	    fprintf(stderr, "%s: line %ld: value out of range, answering 0\n", program, line);
+	    ++ignored_invalid;
+	    batch_bad[n] = 1;
+	}
+    }
+    return n;
+}
+
+
+/*
+ * read_binary - read a batch of raw little-endian 64 bit values
+ *
+ * given:
+ *	inbytes		add the input octets read to this count
+ *
+ * returns:
+ *	number of values read into batch_value[], < BATCH ==> EOF
+ */
+static int
+read_binary(unsigned long long *inbytes)
+{
+    static u_int8_t inbuf[BATCH*WORDOCTETS];	/* raw values */
+    size_t readcnt;	/* octets read */
+    unsigned long v;	/* value being assembled */
+    int n;
+    int i;
+    int j;
+
+    clearerr(stdin);
+    readcnt = fread(inbuf, 1, sizeof(inbuf), stdin);
+    if (ferror(stdin)) {
+	fprintf(stderr, "%s: read error: %s\n", program, strerror(errno));
+	exit(6);
+    }
+    *inbytes += readcnt;
+    if (readcnt % WORDOCTETS != 0) {
+	fprintf(stderr, "%s: ignoring %d octets of a partial value at EOF\n",
+		program, (int)(readcnt % WORDOCTETS));
+	++ignored_invalid;
+    }
+    n = readcnt / WORDOCTETS;
+    for (i=0; i < n; ++i) {
+	v = 0;
+	for (j=WORDOCTETS-1; j >= 0; --j) {
+	    v = (v << OCTETBITS) | inbuf[i*WORDOCTETS + j];
+	}
+	batch_value[i] = v;
+	batch_bad[i] = 0;
+    }
+    return n;
+}
+
+
+/*
+ * locate - find the octet and bit of each value in the batch, and prefetch
+ *
+ * given:
+ *	n	number of values in batch_value[]
+ *
+ * Sets batch_octet[] and batch_mask[].  A value that is malformed, < start,
+ * that cannot be represented, or that is beyond the end of the bitmap
+ * gets a batch_octet[] of NOTSET.
+ */
+static void
+locate(int n)
+{
+    unsigned long d;	/* value less start */
+    unsigned long t;	/* bit offset of value */
+    int bit;		/* wheel bit of value, or -1 */
+    int i;
+
+    for (i=0; i < n; ++i) {
+	batch_octet[i] = NOTSET;
+	if (batch_bad[i] || batch_value[i] < start) {
+	    continue;
+	}
+	d = batch_value[i] - start;
+	if (wheel) {
+	    bit = wheel_bit[d % WHEEL_MOD];
+	    if (bit < 0) {
+		continue;
+	    }
+	    t = d / WHEEL_MOD * OCTETBITS + bit;
+	} else {
+	    if (d % step != 0) {
+		continue;
+	    }
+	    t = d / step;
+	}
+	if (t / OCTETBITS >= maplen) {
+	    continue;
+	}
+	batch_octet[i] = t / OCTETBITS;
+	batch_mask[i] = 1 << (t % OCTETBITS);
+	__builtin_prefetch(map + batch_octet[i]);
+    }
+    return;
+}
+
+
+/*
+ * write_answers - write the answers of a batch in input order
+ *
+ * given:
+ *	n	number of answers in batch_answer[]
+ *	raw	1 ==> write octets, 0 ==> write lines
+ */
+static void
+write_answers(int n, int raw)
+{
+    int i;
+
+    clearerr(stdout);
+    if (raw) {
+	fwrite(batch_answer, 1, n, stdout);
+    } else {
+	for (i=0; i < n; ++i) {
+	    putchar('0' + batch_answer[i]);
+	    putchar('\n');
+	}
+    }
+    if (ferror(stdout)) {
+	fprintf(stderr, "%s: write error: %s\n", program, strerror(errno));
+	exit(7);
+    }
+    return;
+}
+
+
+/*
+ * write_nearest - write the next or previous set value of each value
+ *
+ * given:
+ *	n	number of values in batch_value[]
+ *	query	QUERY_NEXT or QUERY_PREV
+ */
+static void
+write_nearest(int n, int query)
+{
+    unsigned long d;		/* value less start */
+    unsigned long bit;		/* bit to search from */
+    unsigned long found;	/* set bit found, or BITSCAN_NONE */
+    int below;			/* wheel values <= d % WHEEL_MOD */
+    int i;
+
+    clearerr(stdout);
+    for (i=0; i < n; ++i) {
+
+	/*
+	 * find the bit of the first value >= (-N) or <= (-P) the value
+	 * that can be represented, and search from there
+	 */
+	found = BITSCAN_NONE;
+	if (batch_bad[i]) {
+	    /* malformed values have no answer */
+	} else if (query == QUERY_NEXT) {
+	    if (batch_value[i] < start) {
+		bit = 0;
+	    } else {
+		d = batch_value[i] - start;
+		if (wheel) {
+		    bit = d / WHEEL_MOD * OCTETBITS + wheel_below[d % WHEEL_MOD];
+		} else {
+		    bit = d / step + (d % step != 0);
+		}
+	    }
+	    found = bitscan_next_set(map, maplen, summary, bit);
+	} else if (batch_value[i] >= start) {
+	    d = batch_value[i] - start;
+	    if (wheel) {
+		below = wheel_below[d % WHEEL_MOD] + (wheel_bit[d % WHEEL_MOD] >= 0);
+		bit = d / WHEEL_MOD * OCTETBITS + below;
+		if (bit > 0) {
+		    found = bitscan_prev_set(map, maplen, summary, bit - 1);
+		}
+	    } else {
+		found = bitscan_prev_set(map, maplen, summary, d / step);
+	    }
+	}
+
+	/*
+	 * write the set value found
+	 */
+	if (found == BITSCAN_NONE) {
+	    fputs("none\n", stdout);
+	} else {
+	    printf("%ld\n", value_of(found));
+	    ++values_found;
+	}
+    }
+    if (ferror(stdout)) {
+	fprintf(stderr, "%s: write error: %s\n", program, strerror(errno));
+	exit(7);
+    }
+    return;
+}
+
+
+/*
+ * value_of - value represented by a bit of the bitmap
+ *
+ * given:
+ *	bit	bit offset from the beginning of the bitmap
+ *
+ * returns:
+ *	value represented by bit
+ */
+static unsigned long
+value_of(unsigned long bit)
+{
+    if (wheel) {
+	return start + bit / OCTETBITS * WHEEL_MOD + wheel_residue[bit % OCTETBITS];
+    }
+    return start + bit * step;
+}
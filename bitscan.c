@@ -0,0 +1,451 @@
+/*
+ * bitscan - find set bits in a bitmap, with an optional summary bitmap
+ *
+ * Bitmaps are tested a 64 bit word at a time.  The last word of a
+ * bitmap whose length is not a multiple of 8 octets is zero padded.
+ *
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "bitscan.h"
+
+
+/*
+ * useful defines
+ */
+#define OCTETBITS (8)		/* 8 bits per octet */
+#define WORDOCTETS (8)		/* octets per 64 bit word */
+#define WORDBITS (64)		/* bits per 64 bit word */
+#define BLOCKBITS ((unsigned long)SUMMARY_BLOCK*OCTETBITS)	/* bits per block */
+#if defined(__APPLE__)
+#define MTIME_NSEC(st) ((st)->st_mtimespec.tv_nsec)	/* ns of modification time */
+#else
+#define MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)		/* ns of modification time */
+#endif
+
+
+/*
+ * static functions
+ */
+static uint64_t load_word(const u_int8_t *buf, unsigned long len, unsigned long w);
+static void summary_header(u_int8_t *header, const struct stat *mapstat);
+
+
+/*
+ * load_word - load a little-endian 64 bit word of a bitmap
+ *
+ * given:
+ *	buf	bitmap
+ *	len	octets in the bitmap
+ *	w	word number, w*8 < len
+ *
+ * returns:
+ *	word w of the bitmap, where bit b of the word is bitmap bit w*64 + b
+ */
+static uint64_t
+load_word(const u_int8_t *buf, unsigned long len, unsigned long w)
+{
+    uint64_t word;		/* word being loaded */
+    unsigned long off;		/* octet offset of word */
+    unsigned long j;
+
+    off = w * WORDOCTETS;
+    if (len - off >= WORDOCTETS) {
+	memcpy(&word, buf+off, WORDOCTETS);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	word = __builtin_bswap64(word);
+#endif
+    } else {
+	word = 0;
+	for (j=len; j > off; --j) {
+	    word = (word << OCTETBITS) | buf[j-1];
+	}
+    }
+    return word;
+}
+
+
+/*
+ * bitscan_next - find the next set bit of a bitmap
+ *
+ * given:
+ *	buf	bitmap
+ *	len	octets in the bitmap
+ *	bit	first bit to test
+ *	limit	bits >= limit are not tested, limit <= len*8
+ *
+ * returns:
+ *	lowest set bit >= bit and < limit, or BITSCAN_NONE
+ */
+unsigned long
+bitscan_next(const u_int8_t *buf, unsigned long len,
+	     unsigned long bit, unsigned long limit)
+{
+    uint64_t word;		/* word being tested */
+    unsigned long w;		/* word number */
+    unsigned long found;	/* set bit found */
+
+    if (bit >= limit) {
+	return BITSCAN_NONE;
+    }
+    w = bit / WORDBITS;
+    word = load_word(buf, len, w) & (~(uint64_t)0 << (bit % WORDBITS));
+    while (word == 0) {
+	++w;
+	if (w >= (limit + WORDBITS - 1) / WORDBITS) {
+	    return BITSCAN_NONE;
+	}
+	word = load_word(buf, len, w);
+    }
+    found = w * WORDBITS + __builtin_ctzll(word);
+    return (found < limit) ? found : BITSCAN_NONE;
+}
+
+
+/*
+ * bitscan_prev - find the previous set bit of a bitmap
+ *
+ * given:
+ *	buf	bitmap
+ *	len	octets in the bitmap
+ *	bit	first bit to test, bit < len*8
+ *	floor	bits < floor are not tested
+ *
+ * returns:
+ *	highest set bit <= bit and >= floor, or BITSCAN_NONE
+ */
+unsigned long
+bitscan_prev(const u_int8_t *buf, unsigned long len,
+	     unsigned long bit, unsigned long floor)
+{
+    uint64_t word;		/* word being tested */
+    unsigned long w;		/* word number */
+    unsigned long found;	/* set bit found */
+
+    if (bit < floor) {
+	return BITSCAN_NONE;
+    }
+    w = bit / WORDBITS;
+    word = load_word(buf, len, w) & (~(uint64_t)0 >> (WORDBITS-1 - bit % WORDBITS));
+    while (word == 0) {
+	if (w == 0 || w <= floor / WORDBITS) {
+	    return BITSCAN_NONE;
+	}
+	--w;
+	word = load_word(buf, len, w);
+    }
+    found = w * WORDBITS + (WORDBITS-1 - __builtin_clzll(word));
+    return (found >= floor) ? found : BITSCAN_NONE;
+}
+
+
+/*
+ * bitscan_next_set - find the next set bit of a bitmap using a summary
+ *
+ * given:
+ *	map	bitmap
+ *	maplen	octets in the bitmap
+ *	summary	summary of the bitmap, or NULL ==> no summary
+ *	bit	first bit to test
+ *
+ * returns:
+ *	lowest set bit >= bit, or BITSCAN_NONE
+ *
+ * Blocks whose summary bit is 0 are skipped without being read.
+ */
+unsigned long
+bitscan_next_set(const u_int8_t *map, unsigned long maplen,
+		 const u_int8_t *summary, unsigned long bit)
+{
+    unsigned long nbits;	/* bits in the bitmap */
+    unsigned long block;	/* block of bit */
+    unsigned long end;		/* bit just beyond block */
+    unsigned long found;	/* set bit found */
+
+    nbits = maplen * OCTETBITS;
+    if (summary == NULL) {
+	return bitscan_next(map, maplen, bit, nbits);
+    }
+    while (bit < nbits) {
+	block = bit / BLOCKBITS;
+	if ((summary[block / OCTETBITS] & (1 << (block % OCTETBITS))) != 0) {
+	    end = (block+1) * BLOCKBITS;
+	    found = bitscan_next(map, maplen, bit, (end < nbits) ? end : nbits);
+	    if (found != BITSCAN_NONE) {
+		return found;
+	    }
+	}
+	block = bitscan_next(summary, SUMMARY_LEN(maplen), block+1,
+			     SUMMARY_BLOCKS(maplen));
+	if (block == BITSCAN_NONE) {
+	    break;
+	}
+	bit = block * BLOCKBITS;
+    }
+    return BITSCAN_NONE;
+}
+
+
+/*
+ * bitscan_prev_set - find the previous set bit of a bitmap using a summary
+ *
+ * given:
+ *	map	bitmap
+ *	maplen	octets in the bitmap
+ *	summary	summary of the bitmap, or NULL ==> no summary
+ *	bit	first bit to test, may be beyond the end of the bitmap
+ *
+ * returns:
+ *	highest set bit <= bit, or BITSCAN_NONE
+ *
+ * Blocks whose summary bit is 0 are skipped without being read.
+ */
+unsigned long
+bitscan_prev_set(const u_int8_t *map, unsigned long maplen,
+		 const u_int8_t *summary, unsigned long bit)
+{
+    unsigned long nbits;	/* bits in the bitmap */
+    unsigned long block;	/* block of bit */
+    unsigned long found;	/* set bit found */
+
+    nbits = maplen * OCTETBITS;
+    if (nbits == 0) {
+	return BITSCAN_NONE;
+    }
+    if (bit >= nbits) {
+	bit = nbits - 1;
+    }
+    if (summary == NULL) {
+	return bitscan_prev(map, maplen, bit, 0);
+    }
+    for (;;) {
+	block = bit / BLOCKBITS;
+	if ((summary[block / OCTETBITS] & (1 << (block % OCTETBITS))) != 0) {
+	    found = bitscan_prev(map, maplen, bit, block * BLOCKBITS);
+	    if (found != BITSCAN_NONE) {
+		return found;
+	    }
+	}
+	if (block == 0) {
+	    break;
+	}
+	block = bitscan_prev(summary, SUMMARY_LEN(maplen), block-1, 0);
+	if (block == BITSCAN_NONE) {
+	    break;
+	}
+	bit = (block+1) * BLOCKBITS - 1;
+    }
+    return BITSCAN_NONE;
+}
+
+
+/*
+ * bitscan_summary - build the summary of a bitmap
+ *
+ * given:
+ *	map	bitmap
+ *	maplen	octets in the bitmap
+ *
+ * returns:
+ *	malloced summary of SUMMARY_LEN(maplen) octets
+ */
+u_int8_t *
+bitscan_summary(const u_int8_t *map, unsigned long maplen)
+{
+    u_int8_t *summary;		/* summary being built */
+    unsigned long nbits;	/* bits in the bitmap */
+    unsigned long end;		/* bit just beyond block */
+    unsigned long block;
+
+    summary = calloc(SUMMARY_LEN(maplen) + 1, 1);
+    if (summary == NULL) {
+	fprintf(stderr, "bitscan: FATAL: cannot allocate summary\n");
+	exit(14);
+    }
+    nbits = maplen * OCTETBITS;
+    for (block=0; block < SUMMARY_BLOCKS(maplen); ++block) {
+	end = (block+1) * BLOCKBITS;
+	if (bitscan_next(map, maplen, block * BLOCKBITS,
+			 (end < nbits) ? end : nbits) != BITSCAN_NONE) {
+	    summary[block / OCTETBITS] |= (1 << (block % OCTETBITS));
+	}
+    }
+    return summary;
+}
+
+
+/*
+ * bitscan_load_summary - load the summary file of a bitmap
+ *
+ * given:
+ *	prog		program name for warnings
+ *	filename	summary file
+ *	map		bitmap
+ *	maplen		octets in the bitmap
+ *	mapstat		status of the bitmap file
+ *
+ * returns:
+ *	malloced summary of SUMMARY_LEN(maplen) octets
+ *
+ * A summary file of the wrong length, or whose header does not match
+ * the length and modification time of the bitmap file exactly, is out
+ * of date.  When the summary file is missing or out of date, the summary
+ * is built from the bitmap and written to the summary file.  If the
+ * summary file cannot be written, a warning is written and the summary
+ * built is still returned.
+ */
+u_int8_t *
+bitscan_load_summary(const char *prog, const char *filename,
+		     const u_int8_t *map, unsigned long maplen,
+		     const struct stat *mapstat)
+{
+    struct stat sbuf;		/* summary file status */
+    u_int8_t want[SUMMARY_HEADER_LEN];	/* header of an up to date summary */
+    u_int8_t header[SUMMARY_HEADER_LEN];	/* header of the summary file */
+    u_int8_t *summary;		/* summary loaded or built */
+    unsigned long sumlen;	/* octets in the summary */
+    ssize_t cnt;		/* octets read */
+    int fd;			/* summary file descriptor */
+
+    /*
+     * use the summary file if it is up to date
+     */
+    sumlen = SUMMARY_LEN(maplen);
+    summary_header(want, mapstat);
+    fd = open(filename, O_RDONLY);
+    if (fd >= 0) {
+	if (fstat(fd, &sbuf) == 0 &&
+	    (unsigned long)sbuf.st_size == SUMMARY_HEADER_LEN + sumlen &&
+	    read(fd, header, SUMMARY_HEADER_LEN) == SUMMARY_HEADER_LEN &&
+	    memcmp(header, want, SUMMARY_HEADER_LEN) == 0) {
+	    summary = malloc(sumlen + 1);
+	    if (summary == NULL) {
+		fprintf(stderr, "bitscan: FATAL: cannot allocate summary\n");
+		exit(14);
+	    }
+	    cnt = (sumlen > 0) ? read(fd, summary, sumlen) : 0;
+	    if (cnt == (ssize_t)sumlen) {
+		(void) close(fd);
+		return summary;
+	    }
+	    free(summary);
+	}
+	(void) close(fd);
+    }
+
+    /*
+     * build the summary and try to save it
+     */
+    summary = bitscan_summary(map, maplen);
+    bitscan_save_summary(prog, filename, summary, maplen, mapstat);
+    return summary;
+}
+
+
+/*
+ * bitscan_save_summary - write the summary file of a bitmap
+ *
+ * given:
+ *	prog		program name for warnings
+ *	filename	summary file
+ *	summary		summary of the bitmap
+ *	maplen		octets in the bitmap
+ *	mapstat		status of the bitmap file, once it is written
+ *
+ * The summary should be saved after the bitmap is written, with the
+ * status of the bitmap file as written, as the summary file is only
+ * used for a bitmap file of the same length and modification time.
+ * If the summary file cannot be written, a warning is written.
+ */
+void
+bitscan_save_summary(const char *prog, const char *filename,
+		     const u_int8_t *summary, unsigned long maplen,
+		     const struct stat *mapstat)
+{
+    u_int8_t header[SUMMARY_HEADER_LEN];	/* summary file header */
+    unsigned long sumlen;	/* octets in the summary */
+    ssize_t hcnt;		/* header octets written */
+    ssize_t cnt;		/* summary octets written */
+    int fd;			/* summary file descriptor */
+
+    sumlen = SUMMARY_LEN(maplen);
+    summary_header(header, mapstat);
+    fd = open(filename, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (fd < 0) {
+	fprintf(stderr, "%s: WARNING: cannot write summary %s: %s\n",
+		prog, filename, strerror(errno));
+	return;
+    }
+    hcnt = write(fd, header, SUMMARY_HEADER_LEN);
+    cnt = (hcnt == SUMMARY_HEADER_LEN && sumlen > 0) ? write(fd, summary, sumlen) : 0;
+    if (hcnt != SUMMARY_HEADER_LEN || cnt != (ssize_t)sumlen) {
+	fprintf(stderr, "%s: WARNING: cannot write summary %s: %s\n",
+		prog, filename, (hcnt < 0 || cnt < 0) ? strerror(errno) : "short write");
+    }
+    (void) close(fd);
+    return;
+}
+
+
+/*
+ * summary_header - form the summary file header for a bitmap file
+ *
+ * given:
+ *	header	SUMMARY_HEADER_LEN octets to fill in
+ *	mapstat	status of the bitmap file
+ */
+static void
+summary_header(u_int8_t *header, const struct stat *mapstat)
+{
+    uint64_t field[3];		/* length, mtime seconds, mtime nanoseconds */
+    int i;
+    int j;
+
+    memcpy(header, SUMMARY_MAGIC, SUMMARY_MAGIC_LEN);
+    field[0] = (uint64_t)mapstat->st_size;
+    field[1] = (uint64_t)mapstat->st_mtime;
+    field[2] = (uint64_t)MTIME_NSEC(mapstat);
+    for (i=0; i < 3; ++i) {
+	for (j=0; j < 8; ++j) {
+	    header[SUMMARY_MAGIC_LEN + 8*i + j] = (u_int8_t)(field[i] >> (8*j));
+	}
+    }
+    return;
+}
@@ -0,0 +1,95 @@
+/*
+ * bitscan - find set bits in a bitmap, with an optional summary bitmap
+ *
+ * A bitmap octet 'x' bit 'y' is bit number 8*x + y.  bitscan_next()
+ * and bitscan_prev() find the nearest set bit at or after, or at or
+ * before, a given bit number, testing a 64 bit word at a time.
+ *
+ * A summary bitmap holds one bit per SUMMARY_BLOCK octets of a bitmap,
+ * set when that block of the bitmap has at least one set bit.  Summary
+ * bit 'b' is in octet b/8 bit b%8, so a summary is itself a bitmap with
+ * a start of 0 and a step of 1.  A summary is always exactly
+ * SUMMARY_LEN(maplen) octets long, and lets bitscan_next_set() and
+ * bitscan_prev_set() skip long empty stretches of a bitmap a block at
+ * a time.
+ *
+ * A summary file is a SUMMARY_HEADER_LEN octet header followed by the
+ * summary.  The header is SUMMARY_MAGIC followed by the length, and the
+ * modification time in seconds and nanoseconds, of the bitmap file the
+ * summary was saved for, each as an 8 octet little-endian integer.  A
+ * summary file is only used for a bitmap file whose length and
+ * modification time match its header exactly.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#if !defined(INCLUDE_BITSCAN_H)
+#define INCLUDE_BITSCAN_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+
+/*
+ * summary layout
+ */
+#define SUMMARY_BLOCK (4096)		/* bitmap octets per summary bit */
+#define SUMMARY_BLOCKS(maplen) (((maplen) + SUMMARY_BLOCK - 1) / SUMMARY_BLOCK)
+#define SUMMARY_LEN(maplen) ((SUMMARY_BLOCKS(maplen) + 8 - 1) / 8)
+#define BITSCAN_NONE (~0UL)		/* no set bit found */
+
+/*
+ * summary file header
+ */
+#define SUMMARY_MAGIC "bitsum1\n"	/* first octets of a summary file */
+#define SUMMARY_MAGIC_LEN (8)		/* octets in SUMMARY_MAGIC */
+#define SUMMARY_HEADER_LEN (SUMMARY_MAGIC_LEN + 3*8)	/* magic, length, mtime */
+
+
+/*
+ * external functions
+ */
+extern unsigned long bitscan_next(const u_int8_t *buf, unsigned long len,
+				  unsigned long bit, unsigned long limit);
+extern unsigned long bitscan_prev(const u_int8_t *buf, unsigned long len,
+				  unsigned long bit, unsigned long floor);
+extern unsigned long bitscan_next_set(const u_int8_t *map, unsigned long maplen,
+				      const u_int8_t *summary, unsigned long bit);
+extern unsigned long bitscan_prev_set(const u_int8_t *map, unsigned long maplen,
+				      const u_int8_t *summary, unsigned long bit);
+extern u_int8_t *bitscan_summary(const u_int8_t *map, unsigned long maplen);
+extern u_int8_t *bitscan_load_summary(const char *prog, const char *filename,
+				      const u_int8_t *map, unsigned long maplen,
+				      const struct stat *mapstat);
+extern void bitscan_save_summary(const char *prog, const char *filename,
+				 const u_int8_t *summary, unsigned long maplen,
+				 const struct stat *mapstat);
+
+
+#endif /* INCLUDE_BITSCAN_H */
@@ -18,6 +18,24 @@
  * any successor input value <= the previously non-ignored input value
  * will be ignored.  Input integers should be separated by newlines.
  *
+ * When input files are given, integers are read from those files instead
+ * of stdin ("-" is stdin).  Each file must be sorted, but the files may
+ * interleave each other: they are merged as they are read, so a value
+ * found in more than one file is set once, just as a duplicate value in
+ * a single input is.  This does the work of a "sort -m" before bitset,
+ * without the extra process and extra pass over the text.
+ *
+ * An input line may also describe a run of consecutive integers:
+ *
+ *	lo-hi		all integers from lo to hi inclusive
+ *	lo,count	count integers beginning with lo
+ *
+ * A run sets the bits of every value in the run that can be represented
+ * in the bitmap.  Runs are filled a whole octet at a time, so the cost of
+ * a run depends on the number of octets it covers, not on the number of
+ * bits it sets.  A run is sorted by its lo value.  A run that overlaps
+ * the previous non-ignored input value is clipped to begin just beyond it.
+ *
  * Input values that are smaller than the start value are also ignored.
  *
  * Any sorted value that cannot be represented in the bitmap is ignored.  I.e.,
@@ -57,6 +75,20 @@
  *
  *		1 + 2*(x*8 + y) == 16*x + 2*y + 1
  *
+ * With -w, the bitmap uses the mod 30 wheel layout instead (see wheel.h):
+ *
+ *	The bit value from octet 'x' and bit 'y' represents the value:
+ *
+ *		start + 30*x + r[y]
+ *
+ *	where r[] = { 1, 7, 11, 13, 17, 19, 23, 29 } are the residues
+ *	mod 30 of values that are not a multiple of 2, 3 or 5.
+ *
+ *	With -w, step must be 30 and start must be a multiple of 30.
+ *	Values that are a multiple of 2, 3 or 5 cannot be represented
+ *	in the bitmap and are ignored.  A wheel prime bitmap is 8/15 the
+ *	size of an odd only (step 2) prime bitmap.
+ *
  * For each non-ignored input value read on input, its corresponding bit is
  * set to 1.  All other bits are set to 0.  Thus the bitmap that is written
  * has 1's for non-ignored input values and 0's everywhere else.
@@ -71,14 +103,55 @@
  * contains BUFSIZ octets where BUFSIZ is defined by <stdio.h>.
  * Frequently BUFSIZ is 8k octets.
  *
+ * With -a bitmap, the bitmap is written to the bitmap file instead of
+ * stdout, adding to the bits already set in it.  The highest set bit of
+ * the file is the previous non-ignored input value, so input values must
+ * be greater than it.  The bitmap buffer holding that bit is read back
+ * from the file, so its partially filled octets are rewritten with both
+ * the old and the new bits set.  The bitmap file is created if it does
+ * not exist.  This lets a run that died be resumed with the rest of its
+ * input, or new values be added without rebuilding the bitmap, provided
+ * that the same start and step are used.
+ *
+ * With -S bits -o prefix, the bitmap is written as a series of shard
+ * files instead of stdout: prefix.000000 holds the first bits bits of
+ * the bitmap, prefix.000001 the next bits bits, and so on.  bits must be
+ * a multiple of 8.  Each shard is a bitmap with the same step (or wheel
+ * layout) whose start value is the value of its first bit, and the shard
+ * files concatenated in order are the bitmap that would have been
+ * written to stdout.  The manifest prefix.manifest records the start,
+ * length and count of 1 bits of each shard (see manifest.h), so that
+ * popcnt -m and listbit -m can work on the shards in parallel.
+ *
+ * With one or more -t start,step,file, the start and step args are not
+ * given.  Instead each -t writes the bitmap of its own start and step to
+ * its own file, all from a single pass over the input.  Each of these
+ * bitmaps is the same as what "bitset start step" would write to stdout,
+ * except that -w applies to all of them.  This saves reading and parsing
+ * the input once per bitmap when several bitmaps of the same input are
+ * wanted, such as one bitmap per residue class.  Counters reported by -s
+ * are summed over all of the bitmaps.
+ *
  * If the input is malformed (cannot be converted into a signed long long)
  * then an warning message will be sent to stderr.  If the input value is <
  * the previous non-ignored input value (unsorted), an warning message will
- * be sent to stderr.  However duplicate values, values < start and
- * values that cannot be represented in the bitmap (due to step) will
- * be silently ignored.
+ * be sent to stderr.  With -t, this warning is only given when every bitmap
+ * ignores the value.  A run whose hi value is < its lo value, or whose
+ * count is < 0, is also reported as a warning.  However duplicate values,
+ * values < start, empty runs and values that cannot be represented in
+ * the bitmap (due to step) will be silently ignored.
  *
- * Copyright (c) 2001,2015,2023,2025 by Landon Curt Noll.  All Rights Reserved.
+ * With -s, counters of lines read, lines ignored for each reason, bits set
+ * and bitmap buffers written, along with the wall clock and CPU time spent
+ * parsing input and writing output, are written as JSON on stderr at exit.
+ * The same report is written when SIGUSR1 is received.
+ *
+ * With -p, the CPU cycles, instructions, branch-misses and last level
+ * cache misses of the input loop, along with cycles per input octet and
+ * instructions per cycle, are written as JSON on stderr at exit.  This
+ * requires Linux hardware performance counters.
+ *
+ * Copyright (c) 2001,2015,2023,2025,2026 by Landon Curt Noll.  All Rights Reserved.
  *
  * Permission to use, copy, modify, and distribute this software and
  * its documentation for any purpose and without fee is hereby granted,
@@ -116,18 +189,24 @@
 #include <sys/errno.h>
 #include <unistd.h>
 #include <strings.h>
+#include <fcntl.h>
+
+#include "stats.h"
+#include "perfctr.h"
+#include "wheel.h"
+#include "manifest.h"
 
 
 /*
  * official version
  */
-#define VERSION "1.8.1 2025-04-08"          /* format: major.minor YYYY-MM-DD */
+#define VERSION "1.16.0 2026-10-19"          /* format: major.minor YYYY-MM-DD */
 
 
 /*
  * misc constants
  */
-#define MAXLINE (19+1)	/* 2^63-1 is 19 digits long + newline */
+#define MAXLINE (2*(1+19)+1+1)	/* 2 signed 19 digit values + separator + newline */
 #define OCTETBITS (8)	/* 8 bits per octet */
 
 
@@ -135,13 +214,22 @@
  * usage message
  */
 static const char * const usage =
-  "usage: %s [-h] [-V] start step\n"
+  "usage: %s [-h] [-V] [-s] [-p] [-w] [-a bitmap | -S bits -o prefix | -t start,step,file ...]\n"
+        "\t[start step] [file ...]\n"
         "\n"
         "    -h            print help message and exit\n"
         "    -V            print version string and exit\n"
+        "    -s            write stats as JSON on stderr at exit and on SIGUSR1\n"
+        "    -p            write hardware counters of the main loop as JSON on stderr\n"
+        "    -w            use the mod 30 wheel layout (step must be 30)\n"
+        "    -a bitmap     add to the bits of bitmap file instead of writing stdout\n"
+        "    -S bits       write shard files of bits bits instead of stdout\n"
+        "    -o prefix     shard files are prefix.NNNNNN, manifest is prefix.manifest\n"
+        "    -t start,step,file  write the bitmap of start and step to file (repeatable)\n"
         "\n"
-	"    start	   starting bitmap value\n"
-	"    step	   step values between bits\n"
+	"    start	   starting bitmap value (not given with -t)\n"
+	"    step	   step values between bits (not given with -t)\n"
+	"    file	   sorted input file, - ==> stdin (def: read stdin)\n"
         "\n"
         "Exit codes:\n"
         "    0         all OK\n"
@@ -160,36 +248,132 @@ static char *prog = NULL;       /* basename of program */
 static const char * const version = VERSION;
 
 
-/*
- * a BUFSIZ chunk of the output bitmap, with an extra guard octet for safety
- *
- * This is the current bitmap buffer with a first bit value of 'bottom'.
- */
-static u_int8_t buffer[BUFSIZ+1];
-
 /*
  * Zero filled bitmap for when there are large gaps as we need to
  * output 0-filled buffers before setting the next bit.
  */
 static u_int8_t zero[BUFSIZ+1];
 
-
-int
-main(int argc, char *argv[])
-{
+/*
+ * bitmap targets
+ *
+ * Each target is a bitmap with its own start and step, written to its
+ * own output.  Without -t, there is a single target written to stdout.
+ *
+ * The buffer of a target is a BUFSIZ chunk of its output bitmap, with an
+ * extra guard octet for safety.  It holds the bits for values in the
+ * range [bottom, beyond), each span values long.
+ *
+ * Whether a run of an input is sorted depends on the runs of that input
+ * that the target did not ignore, so each target keeps the highest value
+ * it set from each input.  A run ignored by one target does not make a
+ * later, lower run of the same input unsorted for another target.
+ */
+static struct target {
     unsigned long start;	/* starting bitmap value */
     unsigned long step;		/* bitmap increment value */
-    unsigned long value;	/* input value from stdin */
-    unsigned long line;		/* input line number */
     unsigned long bottom;	/* low bit value of bitmap */
     unsigned long span;		/* range of values spanned by a bitmap */
     unsigned long beyond;	/* value of bit just beyond end of bitmap */
     int had_prev;		/* 1 ==> seen a previous non-ignored value */
     unsigned long prev;		/* previous non-ignored value */
-    unsigned long boffset;	/* total bit offset in buffer for value */
-    int octet;			/* octet offset in buffer for value */
-    int bit;			/* bit offset in byte for value */
-    char inbuf[MAXLINE+1];	/* max input line + newline + NUL byte */
+    int *in_had_prev;		/* 1 ==> set a run of input [s] */
+    unsigned long *in_prev;	/* highest value set by a run of input [s] */
+    u_int8_t *buffer;		/* current bitmap buffer, BUFSIZ+1 octets */
+    char *name;			/* output file, NULL ==> stdout */
+    FILE *out;			/* open output */
+} *target = NULL;
+static int ntargets = 0;	/* number of targets */
+static int wheel = 0;		/* 1 ==> -w mod 30 wheel layout */
+
+/*
+ * sharded output, see -S and -o
+ *
+ * The last shard in shards is the one open as shard_stream, if any.
+ */
+static char *oprefix = NULL;		/* -o shard prefix, NULL ==> write stdout */
+static unsigned long long shard_octets = 0;	/* octets per shard */
+static FILE *shard_stream = NULL;	/* current shard file, NULL ==> none */
+static struct manifest shards;		/* shards written */
+static unsigned long shard_alloc = 0;	/* shards allocated */
+
+/*
+ * inputs
+ *
+ * Each input holds its next valid run, if any.  The inputs that are not
+ * at EOF form a heap ordered by the lo value of their next run, so that
+ * heap[0] holds the next run of the merged input.
+ */
+static struct source {
+    FILE *stream;		/* open input */
+    const char *name;		/* input file name, NULL ==> stdin */
+    unsigned long line;		/* input line number */
+    unsigned long lo;		/* lowest value of the next run */
+    unsigned long hi;		/* highest value of the next run */
+} *source = NULL;
+static struct source **heap = NULL;	/* inputs not at EOF */
+static int heaplen = 0;			/* inputs in heap */
+static struct source *taken = NULL;	/* input of the last run returned */
+static char inbuf[MAXLINE+1];		/* max input line + NUL byte */
+static unsigned long long inbytes = 0;	/* octets of valid input lines */
+
+/*
+ * stats counters and phases, see -s
+ */
+static unsigned long long lines_read = 0;		/* input lines read */
+static unsigned long long ignored_too_long = 0;		/* lines too long */
+static unsigned long long ignored_invalid_chars = 0;	/* malformed lines */
+static unsigned long long ignored_out_of_range = 0;	/* value out of range */
+static unsigned long long ignored_invalid_run = 0;	/* hi < lo or count < 0 */
+static unsigned long long ignored_empty_run = 0;	/* count == 0 */
+static unsigned long long ignored_unsorted = 0;		/* value < previous */
+static unsigned long long ignored_duplicate = 0;	/* value == previous */
+static unsigned long long ignored_below_start = 0;	/* value < start */
+static unsigned long long ignored_not_in_bitmap = 0;	/* value != start % step */
+static unsigned long long bits_set = 0;			/* bits set in bitmap */
+static unsigned long long windows_flushed = 0;		/* bitmap buffers written */
+static unsigned long long zero_buffers = 0;		/* 0-filled buffers written */
+static unsigned long long shards_written = 0;		/* -S shard files written */
+static int parse_phase = -1;		/* reading, parsing and setting bits */
+static int write_phase = -1;		/* writing bitmap buffers */
+
+
+/*
+ * static functions
+ */
+static struct target *add_target(unsigned long start, unsigned long step, char *name);
+static int set_target(struct target *t, unsigned long value, unsigned long hi);
+static void flush_to(struct target *t, unsigned long value);
+static void finish_target(struct target *t);
+static void set_bits(struct target *t, unsigned long lo, unsigned long hi);
+static void set_run(struct target *t, unsigned long lo, unsigned long hi);
+static unsigned long bit_offset(struct target *t, unsigned long value);
+static int resume(struct target *t, const char *filename, unsigned long *last);
+static void open_sources(int count, char **name);
+static int ignored_by_all(struct source *src, unsigned long hi);
+static int read_run(struct source *src);
+static struct source *next_run(unsigned long *lo, unsigned long *hi);
+static void sift_down(int i);
+static void warn_line(struct source *src, const char *msg);
+static size_t write_octets(struct target *t, const u_int8_t *buf, size_t len);
+static void open_shard(void);
+static void close_shard(void);
+
+
+int
+main(int argc, char *argv[])
+{
+    unsigned long value;	/* input value from stdin */
+    unsigned long hi;		/* highest value of an input run */
+    int s;			/* input number of the run */
+    struct source *src;		/* input of the run */
+    struct target *t;		/* bitmap target */
+    char *afile = NULL;		/* -a bitmap file, NULL ==> write stdout */
+    unsigned long long sbits = 0;	/* -S bits per shard, 0 ==> no shards */
+    char *mfile;		/* -o manifest file */
+    long long tstart;		/* -t start value */
+    long long tstep;		/* -t step value */
+    char *p;			/* -t parse pointer */
     int i;
 
     /*
@@ -202,7 +386,7 @@ main(int argc, char *argv[])
     } else {
         ++prog;
     }
-    while ((i = getopt(argc, argv, ":hV")) != -1) {
+    while ((i = getopt(argc, argv, ":hVspwa:S:o:t:")) != -1) {
 	switch (i) {
 
         case 'h':                   /* -h - print help message and exit */
@@ -215,6 +399,55 @@ main(int argc, char *argv[])
             exit(2); /* ooo */
             /*NOTREACHED*/
 
+	case 's':                   /* -s - write stats */
+	    stats_setup(prog);
+	    break;
+
+	case 'p':                   /* -p - write hardware counters */
+	    perfctr_setup(prog);
+	    break;
+
+	case 'w':                   /* -w - mod 30 wheel layout */
+	    wheel = 1;
+	    break;
+
+	case 'a':                   /* -a bitmap - add to a bitmap file */
+	    afile = optarg;
+	    break;
+
+	case 'S':                   /* -S bits - bits per shard */
+	    errno = 0;
+	    sbits = strtoull(optarg, NULL, 0);
+	    if (errno == ERANGE || sbits == 0 || sbits % OCTETBITS != 0 ||
+		optarg[0] == '-') {
+		fprintf(stderr, "%s: shard bits must be a multiple of %d > 0: %s\n",
+			program, OCTETBITS, optarg);
+		fprintf(stderr, usage, program, prog, version);
+		exit(3); /* ooo */
+		/*NOTREACHED*/
+	    }
+	    break;
+
+	case 'o':                   /* -o prefix - shard file prefix */
+	    oprefix = optarg;
+	    break;
+
+	case 't':                   /* -t start,step,file - add a target */
+	    errno = 0;
+	    tstep = 0;
+	    tstart = strtoll(optarg, &p, 0);
+	    if (errno != ERANGE && p > optarg && *p == ',') {
+		tstep = strtoll(p+1, &p, 0);
+	    }
+	    if (errno == ERANGE || *p != ',' || p[1] == '\0') {
+		fprintf(stderr, "%s: -t must be start,step,file: %s\n", program, optarg);
+		fprintf(stderr, usage, program, prog, version);
+		exit(3); /* ooo */
+		/*NOTREACHED*/
+	    }
+	    add_target(tstart, tstep, p+1);
+	    break;
+
 	case ':':
             (void) fprintf(stderr, "%s: ERROR: requires an argument -- %c\n", program, optopt);
 	    fprintf(stderr, usage, program, prog, version);
@@ -238,31 +471,66 @@ main(int argc, char *argv[])
     argv += optind;
     argc -= optind;
     /* check the arg count */
-    if (argc != 3) {
-        fprintf(stderr, "%s: ERROR: expected 2 args, found: %d\n", program, argc);
+    if (ntargets == 0 && argc < 2) {
+        fprintf(stderr, "%s: ERROR: expected at least 2 args, found: %d\n", program, argc);
 	fprintf(stderr, usage, program, prog, version);
         exit(3); /* ooo */
         /*NOTREACHED*/
     }
-
-    /* parse start */
-    errno = 0;
-    start = strtoll(argv[1], NULL, 0);
-    if (errno == ERANGE) {
-	fprintf(stderr, "%s: failed to parse start value: %s\n", program, argv[1]);
-        exit(2);
+    if ((sbits != 0) != (oprefix != NULL)) {
+	fprintf(stderr, "%s: -S and -o must be used together\n", program);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if (sbits != 0 && afile != NULL) {
+	fprintf(stderr, "%s: -a and -S conflict\n", program);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if (ntargets > 0 && (afile != NULL || sbits != 0)) {
+	fprintf(stderr, "%s: -t conflicts with -a and -S\n", program);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
     }
 
-    /* parse step */
-    errno = 0;
-    step = strtoll(argv[2], NULL, 0);
-    if (errno == ERANGE) {
-	fprintf(stderr, "%s: failed to parse step value: %s\n", program, argv[2]);
-        exit(3);
+    /*
+     * without -t, the start and step args describe the bitmap on stdout
+     */
+    if (ntargets == 0) {
+
+	/* parse start */
+	errno = 0;
+	tstart = strtoll(argv[0], NULL, 0);
+	if (errno == ERANGE) {
+	    fprintf(stderr, "%s: failed to parse start value: %s\n", program, argv[0]);
+	    exit(2);
+	}
+
+	/* parse step */
+	errno = 0;
+	tstep = strtoll(argv[1], NULL, 0);
+	if (errno == ERANGE) {
+	    fprintf(stderr, "%s: failed to parse step value: %s\n", program, argv[1]);
+	    exit(3);
+	}
+	add_target(tstart, tstep, NULL);
+	argv += 2;
+	argc -= 2;
     }
-    if (step <= 0) {
-	fprintf(stderr, "%s: step: %ld must be > 0\n", program, step);
-	exit(4);
+    for (i=0; i < ntargets; ++i) {
+	t = &target[i];
+	if ((long)t->step <= 0) {
+	    fprintf(stderr, "%s: step: %ld must be > 0\n", program, t->step);
+	    exit(4);
+	}
+	if (wheel && (t->step != WHEEL_MOD || (long)t->start % WHEEL_MOD != 0)) {
+	    fprintf(stderr, "%s: with -w, step must be %d and start a multiple of %d\n",
+		    program, WHEEL_MOD, WHEEL_MOD);
+	    exit(4);
+	}
     }
 
     /*
@@ -275,99 +543,273 @@ main(int argc, char *argv[])
      * or become unsorted.  Either was the non-ignored input will stop at
      * or before the highest possible bit value.
      */
-    line = 0;	/* 1st line will be 1 */
     memset(inbuf, '\0', MAXLINE+1);
-    memset(buffer, '\0', BUFSIZ+1);
     memset(zero, '\0', BUFSIZ+1);
-    bottom = start;
-    span = OCTETBITS*BUFSIZ*step;
-    beyond = start + span;
-    had_prev = 0;	/* no previous non-ignored value */
-    prev = 0;
+    for (i=0; i < ntargets; ++i) {
+	t = &target[i];
+	t->buffer = calloc(BUFSIZ+1, 1);
+	if (t->buffer == NULL) {
+	    fprintf(stderr, "%s: cannot allocate bitmap buffer\n", program);
+	    exit(10);
+	}
+	t->bottom = t->start;
+	if (wheel) {
+	    t->span = BUFSIZ*WHEEL_MOD;
+	} else {
+	    t->span = OCTETBITS*BUFSIZ*t->step;
+	}
+	t->beyond = t->start + t->span;
+	t->had_prev = 0;	/* no previous non-ignored value */
+	t->prev = 0;
+	if (t->name == NULL) {
+	    t->out = stdout;
+	} else {
+	    t->out = fopen(t->name, "w");
+	    if (t->out == NULL) {
+		fprintf(stderr, "%s: cannot create %s: %s\n",
+			program, t->name, strerror(errno));
+		exit(10);
+	    }
+	}
+    }
+    if (afile != NULL) {
+	target[0].had_prev = resume(&target[0], afile, &target[0].prev);
+    }
+    if (oprefix != NULL) {
+	shard_octets = sbits / OCTETBITS;
+	shards.start = target[0].start;
+	shards.step = target[0].step;
+	shards.wheel = wheel;
+	shards.shard_bits = sbits;
+    }
+    stats_counter("lines_read", &lines_read);
+    stats_counter("ignored_too_long", &ignored_too_long);
+    stats_counter("ignored_invalid_chars", &ignored_invalid_chars);
+    stats_counter("ignored_out_of_range", &ignored_out_of_range);
+    stats_counter("ignored_invalid_run", &ignored_invalid_run);
+    stats_counter("ignored_empty_run", &ignored_empty_run);
+    stats_counter("ignored_unsorted", &ignored_unsorted);
+    stats_counter("ignored_duplicate", &ignored_duplicate);
+    stats_counter("ignored_below_start", &ignored_below_start);
+    stats_counter("ignored_not_in_bitmap", &ignored_not_in_bitmap);
+    stats_counter("bits_set", &bits_set);
+    stats_counter("windows_flushed", &windows_flushed);
+    stats_counter("zero_buffers_written", &zero_buffers);
+    if (oprefix != NULL) {
+	stats_counter("shards_written", &shards_written);
+    }
+    parse_phase = stats_phase("parse");
+    write_phase = stats_phase("write");
+    stats_switch(parse_phase);
+    perfctr_start();
+    open_sources(argc, argv);
 
     /*
      * output sieve buffers until EOF
+     *
+     * Each run is offered to every target.  A target ignores a run
+     * that is not above the highest value it set from the same input,
+     * as in ignored_by_all().  Some target uses each run that gets here,
+     * so a run only some targets find unsorted is counted, not warned.
      */
-    clearerr(stdin);
-    while (fgets(inbuf, MAXLINE+1, stdin) != NULL) {
-	char *p;	/* char check pointer */
-
-	/*
-	 * count this line
-	 */
-	++line;
-
-	/*
-	 * sanity check on input
-	 *
-	 * Input must be an integer (with a possible leading -)
-	 * followed by a newline followed by a NUL.
-	 */
-	/* in case no newline was read */
-	inbuf[MAXLINE] = '\0';
-	/* leading - is OK */
-	p = ((inbuf[0] == '-') ? inbuf+1 : inbuf);
-	/* can only have digits followed by newline */
-	while (*p != '\0' && isdigit(*p) && p < inbuf+MAXLINE) {
-	    ++p;
-	}
-	/* we better have stopped on a newline followed by NUL */
-	if (*p != '\n' || *(p+1) != '\0') {
-	    /* improper line, ignore it */
-	    if (*p == '\0') {
-		fprintf(stderr, "%s: line %ld: ignoring, line too long\n",
-			program, line);
-	    } else {
-		fprintf(stderr, "%s: line %ld: ignoring, invalid chars\n",
-			program, line);
+    while ((src = next_run(&value, &hi)) != NULL) {
+	s = src - source;
+	for (i=0; i < ntargets; ++i) {
+	    t = &target[i];
+	    if (t->in_had_prev[s] && hi <= t->in_prev[s]) {
+		if (hi < t->in_prev[s]) {
+		    ++ignored_unsorted;
+		} else {
+		    ++ignored_duplicate;
+		}
+		continue;
+	    }
+	    if (set_target(t, value, hi)) {
+		t->in_had_prev[s] = 1;
+		t->in_prev[s] = t->prev;
 	    }
-	    continue;
 	}
+    }
 
-	/*
-	 * convert input into an input value
-	 */
-	errno = 0;
-	value = strtoll(inbuf, NULL, 0);
-	if (errno == ERANGE) {
-	    fprintf(stderr, "%s: line %ld: ignoring, value out of range\n",
-		    program, line);
-	    continue;
+    /*
+     * write the final partial bitmap buffer of each target
+     */
+    for (i=0; i < ntargets; ++i) {
+	finish_target(&target[i]);
+    }
+
+    /*
+     * with -S, close the last shard and write the manifest
+     */
+    if (oprefix != NULL) {
+	stats_switch(write_phase);
+	close_shard();
+	mfile = malloc(strlen(oprefix) + sizeof(".manifest"));
+	if (mfile == NULL) {
+	    fprintf(stderr, "%s: cannot allocate manifest name\n", program);
+	    exit(10);
 	}
+	sprintf(mfile, "%s.manifest", oprefix);
+	manifest_write(prog, mfile, &shards);
+    }
 
-	/*
-	 * warn if unsorted, silently if equal
-	 */
-	if (had_prev && value <= prev) {
-	    if (value < prev) {
-		fprintf(stderr, "%s: line %ld: ignoring, value not sorted\n",
-			program, line);
-	    }
-	    continue;
+    /*
+     * with -a, drop any 0 octets that the bitmap file had beyond its
+     * highest set bit
+     */
+    if (afile != NULL) {
+	stats_switch(write_phase);
+	if (fflush(stdout) != 0 || ftruncate(fileno(stdout), ftello(stdout)) < 0) {
+	    fprintf(stderr, "%s: cannot truncate %s: %s\n",
+		    program, afile, strerror(errno));
+	    exit(9);
 	}
+    }
 
-	/*
-	 * silently ignore if below start
-	 */
-	if (value < start) {
-	    continue;
+    /*
+     * report hardware counters if -p
+     */
+    fflush(stdout);
+    perfctr_stop(inbytes);
+
+    /*
+     * report stats if -s
+     *
+     * We flush stdout first so that the time to write the final
+     * bitmap octets is charged to the write phase.
+     */
+    if (stats_on) {
+	stats_switch(write_phase);
+	fflush(stdout);
+	stats_switch(-1);
+	stats_report(1);
+    }
+
+    /*
+     * All done!
+     *
+     *	-- Jessica Noll, 1985
+     */
+    exit(0);
+}
+
+
+/*
+ * add_target - add a bitmap target
+ *
+ * given:
+ *	start	starting bitmap value
+ *	step	bitmap increment value
+ *	name	output file, NULL ==> stdout
+ *
+ * returns:
+ *	the new target
+ *
+ * The buffer and output of the target are set up once all of the
+ * command line has been parsed, see main.
+ */
+static struct target *
+add_target(unsigned long start, unsigned long step, char *name)
+{
+    struct target *t;	/* new target */
+
+    target = realloc(target, (ntargets+1) * sizeof(target[0]));
+    if (target == NULL) {
+	fprintf(stderr, "%s: cannot allocate %d targets\n", program, ntargets+1);
+	exit(10);
+    }
+    t = &target[ntargets++];
+    memset(t, 0, sizeof(*t));
+    t->start = start;
+    t->step = step;
+    t->name = name;
+    return t;
+}
+
+
+/*
+ * set_target - set the bits of a run in a target
+ *
+ * given:
+ *	t	target to set
+ *	value	lowest value of the run
+ *	hi	highest value of the run, value <= hi
+ *
+ * returns:
+ *	1 ==> bits were set and t->prev is the highest of them,
+ *	0 ==> the run was ignored by this target
+ */
+static int
+set_target(struct target *t, unsigned long value, unsigned long hi)
+{
+    unsigned long boffset;	/* total bit offset in buffer for value */
+    int octet;			/* octet offset in buffer for value */
+    int bit;			/* bit offset in byte for value */
+
+    /*
+     * silently collapse values already processed
+     *
+     * Each input is checked for sorted order as it is read, so a
+     * run that overlaps values we have already processed came from
+     * another input, or overlaps a run of the same input.  The part
+     * of it that overlaps is silently clipped.
+     */
+    if (t->had_prev && hi <= t->prev) {
+	++ignored_duplicate;
+	return 0;
+    }
+    if (t->had_prev && value <= t->prev) {
+	value = t->prev + 1;
+    }
+
+    /*
+     * silently ignore if below start
+     */
+    if (hi < t->start) {
+	++ignored_below_start;
+	return 0;
+    }
+    if (value < t->start) {
+	value = t->start;
+    }
+
+    /*
+     * silently ignore if not a bitmap potential value
+     *
+     * For a run, we round the lo value up and the hi value down
+     * to the nearest bitmap potential values.
+     */
+    if (wheel) {
+	unsigned long up = wheel_up[(value - t->start) % WHEEL_MOD];
+
+	if (hi - value < up) {
+	    ++ignored_not_in_bitmap;
+	    return 0;
 	}
+	value += up;
+	hi -= wheel_down[(hi - t->start) % WHEEL_MOD];
+    } else {
+	if (((value - t->start) % t->step) != 0) {
+	    unsigned long up = t->step - ((value - t->start) % t->step);
 
-	/*
-	 * silently ignore if not a bitmap potential value
-	 */
-	if (((value - start) % step) != 0) {
-	    continue;
+	    if (hi - value < up) {
+		++ignored_not_in_bitmap;
+		return 0;
+	    }
+	    value += up;
 	}
+	hi -= (hi - t->start) % t->step;
+    }
 
-	/*
-	 * At this point we know that the value will cause us to set a
-	 * bit somewhere in the bitmap, the question is where.  It could
-	 * be on the current bitmap.  It could be in some future bit map
-	 * causing is to have to write this bitmap, followed by 0 or more
-	 * 0-filled bitmaps before being able to set the bit in the new
-	 * bitmap.
-	 */
+    /*
+     * At this point we know that the value will cause us to set a
+     * bit somewhere in the bitmap, the question is where.  It could
+     * be on the current bitmap.  It could be in some future bit map
+     * causing is to have to write this bitmap, followed by 0 or more
+     * 0-filled bitmaps before being able to set the bit in the new
+     * bitmap.
+     */
+    if (value == hi) {
 
 	/*
 	 * case: value is beyond current bitmap
@@ -375,54 +817,8 @@ main(int argc, char *argv[])
 	 * NOTE: We must check for beyond > bottom because the current
 	 *	 bitmap buffer could go beyond 2^63-1.
 	 */
-	if (beyond > bottom && value >= beyond) {
-
-	    /*
-	     * write the current bitmap buffer
-	     */
-	    clearerr(stdout);
-	    if (fwrite(buffer, 1, BUFSIZ, stdout) != BUFSIZ) {
-		fprintf(stderr, "%s: buffer write error: %s\n",
-			program, strerror(errno));
-		exit(5);
-	    }
-
-	    /*
-	     * If there is a large gap, then we may need to write out
-	     * 1 or more zero filled buffers.  In any event we must
-	     * at least update the bitmap buffer 'bottom' and 'beyond' values.
-	     */
-	    do {
-		/* update bitmap buffer range values */
-		bottom += span;
-		beyond += span;
-
-		/*
-		 * determine if 0-filled bitmap buffer needs to be written
-		 *
-		 * NOTE: We must check for beyond > bottom because the current
-		 *	 bitmap buffer could go beyond 2^63-1.
-		 */
-		if (beyond > bottom && value >= beyond) {
-
-		    /*
-		     * write the 0-filled bitmap buffer
-		     */
-		    clearerr(stdout);
-		    if (fwrite(zero, 1, BUFSIZ, stdout) != BUFSIZ) {
-			fprintf(stderr, "%s: 0-buffer write error: %s\n",
-				program, strerror(errno));
-			exit(6);
-		    }
-		}
-	    /* NOTE: beyond > bottom magic again */
-	    } while (beyond > bottom && value >= beyond);
-
-	    /*
-	     * We have just written our older bitmap buffer, so we must zero it
-	     * out for the new range to use.
-	     */
-	    memset(buffer, '\0', BUFSIZ+1);
+	if (t->beyond > t->bottom && value >= t->beyond) {
+	    flush_to(t, value);
 	}
 
 	/*
@@ -430,14 +826,14 @@ main(int argc, char *argv[])
 	 * bitmap buffer.  We will now determine where the bit to be set
 	 * resides.
 	 */
-	boffset = (value - bottom) / step;
+	boffset = bit_offset(t, value);
 	/* firewall */
 	if (boffset > (u_int64_t)BUFSIZ*OCTETBITS) {
 	    fprintf(stderr, "%s: FATAL: unexpected bit offset: %ld > %d\n",
 		    program, boffset, BUFSIZ*OCTETBITS);
 	    fprintf(stderr, "%s: FATAL: prev: %ld value: %ld "
 			    "bottom: %ld beyond: %ld\n",
-			    program, prev, value, bottom, beyond);
+			    program, t->prev, value, t->bottom, t->beyond);
 	    exit(7);
 	}
 	octet = (int)(boffset / OCTETBITS);
@@ -446,55 +842,879 @@ main(int argc, char *argv[])
 	/*
 	 * Set the bit ... this is where the useful work is done!  :-)
 	 */
-	buffer[octet] |= (1<<bit);
+	t->buffer[octet] |= (1<<bit);
+	++bits_set;
+
+    } else {
 
 	/*
-	 * note that we have a (perhaps new) non-ignored previous value
+	 * Set the bits of the run, flushing bitmap buffers as needed
 	 */
-	had_prev = 1;
-	prev = value;
-	/* clear any error flags */
-	clearerr(stdin);
+	bits_set += bit_offset(t, hi) - bit_offset(t, value) + 1;
+	set_run(t, value, hi);
     }
 
     /*
-     * firewall - catch the case of stdin error
+     * note that we have a (perhaps new) non-ignored previous value
      */
-    if (ferror(stdin)) {
-	fprintf(stderr, "%s: read error: %s\n", program, strerror(errno));
-	exit(8);
-    }
+    t->had_prev = 1;
+    t->prev = hi;
+    return 1;
+}
 
-    /*
-     * We have reached the end of input, so it is time to output the
-     * current and partial bitmap buffer.  It is possible that we did not find
-     * any values, and thus the buffer will be empty.  It is also possible
-     * that we will write only a few of the bitmap buffer octets as we
-     * will stop writing at the last octet for which there is a 1 bit.
-     */
+
+/*
+ * finish_target - write the final bitmap buffer of a target
+ *
+ * given:
+ *	t	target to finish
+ *
+ * We have reached the end of input, so it is time to output the
+ * current and partial bitmap buffer.  It is possible that we did not find
+ * any values, and thus the buffer will be empty.  It is also possible
+ * that we will write only a few of the bitmap buffer octets as we
+ * will stop writing at the last octet for which there is a 1 bit.
+ *
+ * A -t output file is closed.  stdout is left open.
+ */
+static void
+finish_target(struct target *t)
+{
+    int octet;		/* highest octet with a 1 bit, if any */
 
     /*
      * determine the highest octet for which there is a 1 bit, if any
      */
-    for (octet = BUFSIZ-1; octet >= 0 && buffer[octet] == 0; --octet) {
+    for (octet = BUFSIZ-1; octet >= 0 && t->buffer[octet] == 0; --octet) {
     }
 
     /*
      * write out only the bitmap octets that are needed, if any
      */
     if (octet >= 0) {
-	clearerr(stdout);
-	if (fwrite(buffer, 1, octet+1, stdout) != octet+1) {
+	stats_switch(write_phase);
+	clearerr(t->out);
+	if (write_octets(t, t->buffer, octet+1) != octet+1) {
 	    fprintf(stderr, "%s: final buffer write error: %s\n",
 		    program, strerror(errno));
 	    exit(9);
 	}
+	++windows_flushed;
+	stats_bytes(write_phase, octet+1);
     }
 
     /*
-     * All done!
-     *
-     *	-- Jessica Noll, 1985
+     * close a -t output file
      */
-    exit(0);
+    if (t->out != stdout) {
+	stats_switch(write_phase);
+	if (fclose(t->out) != 0) {
+	    fprintf(stderr, "%s: cannot write %s: %s\n",
+		    program, t->name, strerror(errno));
+	    exit(9);
+	}
+	t->out = NULL;
+    }
+    return;
+}
+
+
+/*
+ * flush_to - write bitmap buffers until value is in the current bitmap
+ *
+ * given:
+ *	t	target to write
+ *	value	value beyond the current bitmap buffer
+ *
+ * The current bitmap buffer is written, followed by any 0-filled bitmap
+ * buffers needed to reach the bitmap buffer that holds value.  The
+ * current bitmap buffer is then cleared for use with its new range.
+ */
+static void
+flush_to(struct target *t, unsigned long value)
+{
+    /*
+     * write the current bitmap buffer
+     */
+    stats_switch(write_phase);
+    clearerr(t->out);
+    if (write_octets(t, t->buffer, BUFSIZ) != BUFSIZ) {
+	fprintf(stderr, "%s: buffer write error: %s\n",
+		program, strerror(errno));
+	exit(5);
+    }
+    ++windows_flushed;
+    stats_bytes(write_phase, BUFSIZ);
+
+    /*
+     * If there is a large gap, then we may need to write out
+     * 1 or more zero filled buffers.  In any event we must
+     * at least update the bitmap buffer 'bottom' and 'beyond' values.
+     */
+    do {
+	/* update bitmap buffer range values */
+	t->bottom += t->span;
+	t->beyond += t->span;
+
+	/*
+	 * determine if 0-filled bitmap buffer needs to be written
+	 *
+	 * NOTE: We must check for beyond > bottom because the current
+	 *	 bitmap buffer could go beyond 2^63-1.
+	 */
+	if (t->beyond > t->bottom && value >= t->beyond) {
+
+	    /*
+	     * write the 0-filled bitmap buffer
+	     */
+	    clearerr(t->out);
+	    if (write_octets(t, zero, BUFSIZ) != BUFSIZ) {
+		fprintf(stderr, "%s: 0-buffer write error: %s\n",
+			program, strerror(errno));
+		exit(6);
+	    }
+	    ++zero_buffers;
+	    stats_bytes(write_phase, BUFSIZ);
+	}
+    /* NOTE: beyond > bottom magic again */
+    } while (t->beyond > t->bottom && value >= t->beyond);
+
+    /*
+     * We have just written our older bitmap buffer, so we must zero it
+     * out for the new range to use.
+     */
+    memset(t->buffer, '\0', BUFSIZ+1);
+    stats_switch(parse_phase);
+    return;
+}
+
+
+/*
+ * set_bits - set a range of bits in the current bitmap buffer
+ *
+ * given:
+ *	t	target to set
+ *	lo	bit offset of the first bit to set
+ *	hi	bit offset of the last bit to set, lo <= hi < BUFSIZ*OCTETBITS
+ *
+ * The partial octets at either edge are set with a mask while the whole
+ * octets in between are set all at once.
+ */
+static void
+set_bits(struct target *t, unsigned long lo, unsigned long hi)
+{
+    unsigned long lo_octet = lo / OCTETBITS;	/* octet holding lo bit */
+    unsigned long hi_octet = hi / OCTETBITS;	/* octet holding hi bit */
+    u_int8_t lo_mask;	/* bits at and above lo in lo_octet */
+    u_int8_t hi_mask;	/* bits at and below hi in hi_octet */
+
+    lo_mask = (u_int8_t)(0xff << (lo % OCTETBITS));
+    hi_mask = (u_int8_t)(0xff >> (OCTETBITS-1 - (hi % OCTETBITS)));
+
+    /*
+     * case: the bits are all within a single octet
+     */
+    if (lo_octet == hi_octet) {
+	t->buffer[lo_octet] |= (lo_mask & hi_mask);
+	return;
+    }
+
+    /*
+     * set the edge octets and fill the whole octets in between
+     */
+    t->buffer[lo_octet] |= lo_mask;
+    if (hi_octet > lo_octet+1) {
+	memset(t->buffer+lo_octet+1, 0xff, hi_octet - lo_octet - 1);
+    }
+    t->buffer[hi_octet] |= hi_mask;
+    return;
+}
+
+
+/*
+ * set_run - set the bits for a run of values
+ *
+ * given:
+ *	t	target to set
+ *	lo	lowest value of the run
+ *	hi	highest value of the run, lo < hi
+ *
+ * Both lo and hi must be potential bitmap values >= start.  The bits
+ * of a run are consecutive in both the step and wheel layouts.  The run
+ * is set one bitmap buffer at a time, writing bitmap buffers as the
+ * run spills beyond the current bitmap buffer.
+ */
+static void
+set_run(struct target *t, unsigned long lo, unsigned long hi)
+{
+    unsigned long first;	/* bit offset of lo in the bitmap buffer */
+    unsigned long last;		/* last bit offset to set in bitmap buffer */
+    unsigned long left;		/* bits of the run after first */
+
+    for (;;) {
+
+	/*
+	 * move the bitmap buffer up to the lowest value of the run
+	 *
+	 * NOTE: We must check for beyond > bottom because the current
+	 *	 bitmap buffer could go beyond 2^63-1.
+	 */
+	if (t->beyond > t->bottom && lo >= t->beyond) {
+	    flush_to(t, lo);
+	}
+
+	/*
+	 * set what we can of the run in the current bitmap buffer
+	 */
+	first = bit_offset(t, lo);
+	left = bit_offset(t, hi) - first;
+	if (left > (unsigned long)BUFSIZ*OCTETBITS - 1 - first) {
+	    last = (unsigned long)BUFSIZ*OCTETBITS - 1;
+	} else {
+	    last = first + left;
+	}
+	set_bits(t, first, last);
+
+	/*
+	 * stop when the whole run has been set
+	 */
+	if (last - first == left) {
+	    break;
+	}
+	lo = t->beyond;
+    }
+    return;
+}
+
+
+/*
+ * bit_offset - bit offset of a value from the start of the bitmap buffer
+ *
+ * given:
+ *	t	target of the bitmap buffer
+ *	value	potential bitmap value >= bottom
+ *
+ * returns:
+ *	bit offset of value from the 1st bit of the bitmap buffer
+ *
+ * For the wheel layout, a value that cannot be represented returns
+ * the bit offset of the next value that can be.
+ */
+static unsigned long
+bit_offset(struct target *t, unsigned long value)
+{
+    if (wheel) {
+	return (value - t->bottom) / WHEEL_MOD * OCTETBITS +
+	       wheel_below[(value - t->bottom) % WHEEL_MOD];
+    }
+    return (value - t->bottom) / t->step;
+}
+
+
+/*
+ * read_run - read the next valid run of an input
+ *
+ * given:
+ *	src	input to read
+ *
+ * returns:
+ *	1 ==> src->lo and src->hi hold the next run, 0 ==> EOF
+ *
+ * Malformed lines are reported and skipped, and so are runs that every
+ * target ignores as not sorted (see ignored_by_all()).  A single value
+ * is a run with lo == hi.
+ */
+static int
+read_run(struct source *src)
+{
+    unsigned long value;	/* lowest value of the run */
+    unsigned long hi;		/* highest value of the run */
+
+    clearerr(src->stream);
+    while (fgets(inbuf, MAXLINE+1, src->stream) != NULL) {
+	char *p;	/* char check pointer */
+	char *sep;	/* run separator, or NULL ==> single value */
+	char *q;	/* start of run hi value or count */
+
+	/*
+	 * count this line
+	 */
+	++src->line;
+	++lines_read;
+	if (stats_wanted) {
+	    stats_report(0);
+	}
+
+	/*
+	 * sanity check on input
+	 *
+	 * Input must be an integer (with a possible leading -), or a
+	 * run of the form lo-hi or lo,count, followed by a newline
+	 * followed by a NUL.
+	 */
+	/* in case no newline was read */
+	inbuf[MAXLINE] = '\0';
+	/* leading - is OK */
+	p = ((inbuf[0] == '-') ? inbuf+1 : inbuf);
+	/* can only have digits followed by newline */
+	while (*p != '\0' && isdigit(*p) && p < inbuf+MAXLINE) {
+	    ++p;
+	}
+	/* a - or , after at least one digit starts the 2nd value of a run */
+	sep = NULL;
+	if ((*p == '-' || *p == ',') && p > inbuf && isdigit(*(p-1))) {
+	    sep = p++;
+	    /* leading - is OK */
+	    if (*p == '-') {
+		++p;
+	    }
+	    /* the 2nd value must have at least one digit */
+	    q = p;
+	    while (*p != '\0' && isdigit(*p) && p < inbuf+MAXLINE) {
+		++p;
+	    }
+	    if (p == q && *p == '\n') {
+		warn_line(src, "invalid chars");
+		++ignored_invalid_chars;
+		continue;
+	    }
+	}
+	/* we better have stopped on a newline followed by NUL */
+	if (*p != '\n' || *(p+1) != '\0') {
+	    /* improper line, ignore it */
+	    if (*p == '\0') {
+		warn_line(src, "line too long");
+		++ignored_too_long;
+	    } else {
+		warn_line(src, "invalid chars");
+		++ignored_invalid_chars;
+	    }
+	    continue;
+	}
+	stats_bytes(parse_phase, p+1 - inbuf);
+	inbytes += p+1 - inbuf;
+
+	/*
+	 * convert input into an input value
+	 */
+	errno = 0;
+	value = strtoll(inbuf, NULL, 0);
+	if (errno == ERANGE) {
+	    warn_line(src, "value out of range");
+	    ++ignored_out_of_range;
+	    continue;
+	}
+
+	/*
+	 * convert the 2nd value of a run into the highest value of the run
+	 */
+	if (sep == NULL) {
+	    hi = value;
+	} else {
+	    long long second;	/* run hi value or count */
+
+	    errno = 0;
+	    second = strtoll(sep+1, NULL, 0);
+	    if (errno == ERANGE) {
+		warn_line(src, "value out of range");
+		++ignored_out_of_range;
+		continue;
+	    }
+	    if (*sep == ',') {
+		if (second < 0) {
+		    warn_line(src, "invalid run count");
+		    ++ignored_invalid_run;
+		    continue;
+		}
+		/* silently ignore empty runs */
+		if (second == 0) {
+		    ++ignored_empty_run;
+		    continue;
+		}
+		hi = value + (second - 1);
+		if (hi < value) {
+		    warn_line(src, "value out of range");
+		    ++ignored_out_of_range;
+		    continue;
+		}
+	    } else {
+		hi = second;
+		if (hi < value) {
+		    warn_line(src, "invalid run");
+		    ++ignored_invalid_run;
+		    continue;
+		}
+	    }
+	}
+
+	/*
+	 * skip if no target will use it
+	 */
+	if (ignored_by_all(src, hi)) {
+	    continue;
+	}
+	src->lo = value;
+	src->hi = hi;
+	return 1;
+    }
+
+    /*
+     * firewall - catch the case of an input error
+     */
+    if (ferror(src->stream)) {
+	fprintf(stderr, "%s: %s: read error: %s\n",
+		program, (src->name == NULL) ? "stdin" : src->name, strerror(errno));
+	exit(8);
+    }
+    return 0;
+}
+
+
+/*
+ * ignored_by_all - report and count a run that every target ignores
+ *
+ * given:
+ *	src	input of the run
+ *	hi	highest value of the run
+ *
+ * returns:
+ *	1 ==> every target ignores the run, 0 ==> some target may use it
+ *
+ * A target ignores a run of an input that is not above the highest
+ * value the target set from that input, warning if it is below it
+ * (unsorted) and silently if equal.  With a single target, this skips
+ * every such run as it is read.  With -t, a run that only some targets
+ * ignore is checked again by each target in main().
+ */
+static int
+ignored_by_all(struct source *src, unsigned long hi)
+{
+    struct target *t;		/* bitmap target */
+    int unsorted;		/* 1 ==> a target found the run unsorted */
+    int s;			/* input number of the run */
+    int i;
+
+    s = src - source;
+    for (i=0; i < ntargets; ++i) {
+	t = &target[i];
+	if (!t->in_had_prev[s] || hi > t->in_prev[s]) {
+	    return 0;
+	}
+    }
+    unsorted = 0;
+    for (i=0; i < ntargets; ++i) {
+	if (hi < target[i].in_prev[s]) {
+	    ++ignored_unsorted;
+	    unsorted = 1;
+	} else {
+	    ++ignored_duplicate;
+	}
+    }
+    if (unsorted) {
+	warn_line(src, "value not sorted");
+    }
+    return 1;
+}
+
+
+/*
+ * open_sources - open the inputs and read the first run of each
+ *
+ * given:
+ *	count		number of input files, 0 ==> read stdin
+ *	name		input file names, "-" ==> stdin
+ *
+ * Each target starts with its highest value already set, if any (see -a),
+ * as the highest value it set from each input.
+ */
+static void
+open_sources(int count, char **name)
+{
+    struct source *src;		/* input being opened */
+    struct target *t;		/* bitmap target */
+    int i;
+    int j;
+
+    /*
+     * open the inputs
+     */
+    if (count == 0) {
+	count = 1;
+	name = NULL;
+    }
+    source = calloc(count, sizeof(source[0]));
+    heap = calloc(count, sizeof(heap[0]));
+    if (source == NULL || heap == NULL) {
+	fprintf(stderr, "%s: cannot allocate %d inputs\n", program, count);
+	exit(10);
+    }
+    for (j=0; j < ntargets; ++j) {
+	t = &target[j];
+	t->in_had_prev = calloc(count, sizeof(t->in_had_prev[0]));
+	t->in_prev = calloc(count, sizeof(t->in_prev[0]));
+	if (t->in_had_prev == NULL || t->in_prev == NULL) {
+	    fprintf(stderr, "%s: cannot allocate %d inputs\n", program, count);
+	    exit(10);
+	}
+	for (i=0; i < count; ++i) {
+	    t->in_had_prev[i] = t->had_prev;
+	    t->in_prev[i] = t->prev;
+	}
+    }
+    for (i=0; i < count; ++i) {
+	src = &source[i];
+	if (name == NULL || strcmp(name[i], "-") == 0) {
+	    src->stream = stdin;
+	    src->name = NULL;
+	} else {
+	    src->stream = fopen(name[i], "r");
+	    if (src->stream == NULL) {
+		fprintf(stderr, "%s: cannot open %s: %s\n",
+			program, name[i], strerror(errno));
+		exit(10);
+	    }
+	    src->name = name[i];
+	}
+
+	/*
+	 * inputs at EOF do not join the heap
+	 */
+	if (read_run(src)) {
+	    heap[heaplen++] = src;
+	}
+    }
+
+    /*
+     * order the heap
+     */
+    for (i = heaplen/2 - 1; i >= 0; --i) {
+	sift_down(i);
+    }
+    return;
+}
+
+
+/*
+ * next_run - return the next run of the merged inputs
+ *
+ * given:
+ *	lo	set to the lowest value of the run
+ *	hi	set to the highest value of the run
+ *
+ * returns:
+ *	input of the run, or NULL ==> all inputs are at EOF
+ *
+ * Runs are returned in order of their lo values.  The input of the run
+ * returned last time reads its next run now, after the caller has noted
+ * whether that run was ignored, and moves down the heap, or leaves the
+ * heap if it is at EOF.
+ */
+static struct source *
+next_run(unsigned long *lo, unsigned long *hi)
+{
+    /*
+     * replace the run returned last time, which is still at heap[0]
+     */
+    if (taken != NULL) {
+	if (!read_run(taken)) {
+	    if (taken->stream != stdin) {
+		fclose(taken->stream);
+	    }
+	    heap[0] = heap[--heaplen];
+	}
+	sift_down(0);
+    }
+
+    /*
+     * return the lowest run
+     */
+    if (heaplen == 0) {
+	taken = NULL;
+	return NULL;
+    }
+    taken = heap[0];
+    *lo = taken->lo;
+    *hi = taken->hi;
+    return taken;
+}
+
+
+/*
+ * sift_down - move an input down the heap to its place
+ *
+ * given:
+ *	i	heap index of the input to move
+ */
+static void
+sift_down(int i)
+{
+    struct source *src;		/* input being moved */
+    int child;			/* child of i with the lower next run */
+
+    if (i >= heaplen) {
+	return;
+    }
+    src = heap[i];
+    while ((child = 2*i + 1) < heaplen) {
+	if (child+1 < heaplen && heap[child+1]->lo < heap[child]->lo) {
+	    ++child;
+	}
+	if (src->lo <= heap[child]->lo) {
+	    break;
+	}
+	heap[i] = heap[child];
+	i = child;
+    }
+    heap[i] = src;
+    return;
+}
+
+
+/*
+ * warn_line - warn about an ignored input line
+ *
+ * given:
+ *	src	input of the line
+ *	msg	why the line is ignored
+ */
+static void
+warn_line(struct source *src, const char *msg)
+{
+    if (src->name == NULL) {
+	fprintf(stderr, "%s: line %ld: ignoring, %s\n", program, src->line, msg);
+    } else {
+	fprintf(stderr, "%s: %s: line %ld: ignoring, %s\n",
+		program, src->name, src->line, msg);
+    }
+    return;
+}
+
+
+/*
+ * resume - continue the bitmap in a bitmap file, see -a
+ *
+ * given:
+ *	t		target to resume
+ *	filename	bitmap file to add to, created if needed
+ *	last		set to the value of the highest set bit, if any
+ *
+ * returns:
+ *	1 ==> *last is the value of the highest set bit, 0 ==> no bits set
+ *
+ * The bitmap file replaces stdout.  The bitmap buffer holding the highest
+ * set bit is read back into the current bitmap buffer, and stdout is
+ * positioned at the start of that buffer in the file, so the buffer is
+ * rewritten when it is next written.
+ */
+static int
+resume(struct target *t, const char *filename, unsigned long *last)
+{
+    off_t size;		/* length of the bitmap file */
+    off_t pos;		/* file offset of the octets read */
+    off_t top;		/* file offset of the highest nonzero octet */
+    off_t window;	/* file offset of the bitmap buffer holding top */
+    size_t len;		/* octets to read */
+    int fd;		/* bitmap file descriptor */
+    int bit;		/* highest set bit of the top octet */
+    int i;
+
+    /*
+     * open the bitmap file in place of stdout
+     */
+    fd = open(filename, O_RDWR|O_CREAT, 0644);
+    if (fd < 0 || close(fd) < 0 || freopen(filename, "r+", stdout) == NULL) {
+	fprintf(stderr, "%s: cannot open %s: %s\n", program, filename, strerror(errno));
+	exit(10);
+    }
+    if (fseeko(stdout, 0, SEEK_END) < 0 || (size = ftello(stdout)) < 0) {
+	fprintf(stderr, "%s: cannot seek %s: %s\n", program, filename, strerror(errno));
+	exit(10);
+    }
+
+    /*
+     * find the highest nonzero octet, reading back from the end
+     */
+    top = -1;
+    for (pos = size; pos > 0 && top < 0; ) {
+	len = (pos > BUFSIZ) ? BUFSIZ : pos;
+	pos -= len;
+	if (fseeko(stdout, pos, SEEK_SET) < 0 || fread(t->buffer, 1, len, stdout) != len) {
+	    fprintf(stderr, "%s: cannot read %s: %s\n", program, filename, strerror(errno));
+	    exit(10);
+	}
+	for (i = len-1; i >= 0; --i) {
+	    if (t->buffer[i] != 0) {
+		top = pos + i;
+		break;
+	    }
+	}
+    }
+    memset(t->buffer, '\0', BUFSIZ+1);
+
+    /*
+     * read back the bitmap buffer holding the highest set bit
+     */
+    window = (top < 0) ? 0 : (top / BUFSIZ) * BUFSIZ;
+    if (top >= 0) {
+	len = top+1 - window;
+	if (fseeko(stdout, window, SEEK_SET) < 0 || fread(t->buffer, 1, len, stdout) != len) {
+	    fprintf(stderr, "%s: cannot read %s: %s\n", program, filename, strerror(errno));
+	    exit(10);
+	}
+    }
+    if (fseeko(stdout, window, SEEK_SET) < 0) {
+	fprintf(stderr, "%s: cannot seek %s: %s\n", program, filename, strerror(errno));
+	exit(10);
+    }
+    t->bottom = t->start + (window / BUFSIZ) * t->span;
+    t->beyond = t->bottom + t->span;
+    if (top < 0) {
+	return 0;
+    }
+
+    /*
+     * determine the value of the highest set bit
+     */
+    for (bit = OCTETBITS-1; (t->buffer[top - window] & (1<<bit)) == 0; --bit) {
+    }
+    if (wheel) {
+	*last = t->bottom + (top - window) * WHEEL_MOD + wheel_residue[bit];
+    } else {
+	*last = t->bottom + ((top - window) * OCTETBITS + bit) * t->step;
+    }
+    return 1;
+}
+
+
+/*
+ * write_octets - write octets of the bitmap
+ *
+ * given:
+ *	t	target of the octets
+ *	buf	octets to write
+ *	len	number of octets to write
+ *
+ * returns:
+ *	number of octets written, < len ==> write error
+ *
+ * Without -S, the octets are written to stdout.  With -S, they are
+ * written to the current shard, rolling to a new shard whenever the
+ * current one is full, and the 1 bits of each shard are counted.
+ */
+static size_t
+write_octets(struct target *t, const u_int8_t *buf, size_t len)
+{
+    struct shard *s;	/* current shard */
+    u_int64_t word;	/* 64 bits of buf */
+    size_t done;	/* octets written */
+    size_t n;		/* octets to write to the current shard */
+    size_t i;
+
+    if (oprefix == NULL) {
+	return fwrite(buf, 1, len, t->out);
+    }
+    for (done = 0; done < len; done += n) {
+	if (shard_stream == NULL ||
+	    shards.shard[shards.nshards-1].octets == shard_octets) {
+	    close_shard();
+	    open_shard();
+	}
+	s = &shards.shard[shards.nshards-1];
+	n = len - done;
+	if (n > shard_octets - s->octets) {
+	    n = shard_octets - s->octets;
+	}
+	clearerr(shard_stream);
+	if (fwrite(buf+done, 1, n, shard_stream) != n) {
+	    return done;
+	}
+	s->octets += n;
+	for (i=0; i + sizeof(word) <= n; i += sizeof(word)) {
+	    memcpy(&word, buf+done+i, sizeof(word));
+	    s->count += __builtin_popcountll(word);
+	}
+	for (; i < n; ++i) {
+	    s->count += __builtin_popcount(buf[done+i]);
+	}
+    }
+    return len;
+}
+
+
+/*
+ * open_shard - open the next shard file
+ *
+ * The shard is added to the shards of the manifest, with no octets yet.
+ */
+static void
+open_shard(void)
+{
+    struct shard *s;		/* new shard */
+    unsigned long long bit;	/* bit offset of the shard in the bitmap */
+    char *path;			/* shard file path */
+    char *slash;		/* last / of path, NULL ==> none */
+
+    /*
+     * add a shard to the manifest
+     */
+    if (shards.nshards >= shard_alloc) {
+	shard_alloc = (shard_alloc == 0) ? 64 : 2*shard_alloc;
+	shards.shard = realloc(shards.shard, shard_alloc * sizeof(shards.shard[0]));
+	if (shards.shard == NULL) {
+	    fprintf(stderr, "%s: cannot allocate shards\n", program);
+	    exit(10);
+	}
+    }
+    s = &shards.shard[shards.nshards];
+    bit = shards.nshards * shards.shard_bits;
+    s->bit = bit;
+    if (wheel) {
+	s->first = shards.start + bit / OCTETBITS * WHEEL_MOD;
+    } else {
+	s->first = shards.start + bit * shards.step;
+    }
+    s->octets = 0;
+    s->count = 0;
+
+    /*
+     * open the shard file
+     *
+     * The manifest is in the same directory as the shards, so it names
+     * each shard without the directory.
+     */
+    path = malloc(strlen(oprefix) + 1 + 20 + 1);
+    if (path == NULL) {
+	fprintf(stderr, "%s: cannot allocate shard name\n", program);
+	exit(10);
+    }
+    sprintf(path, "%s.%06lu", oprefix, shards.nshards);
+    shard_stream = fopen(path, "w");
+    if (shard_stream == NULL) {
+	fprintf(stderr, "%s: cannot create %s: %s\n", program, path, strerror(errno));
+	exit(10);
+    }
+    slash = strrchr(path, '/');
+    s->name = (slash == NULL) ? path : slash+1;
+    ++shards.nshards;
+    ++shards_written;
+    return;
+}
+
+
+/*
+ * close_shard - close the current shard file, if any
+ */
+static void
+close_shard(void)
+{
+    if (shard_stream == NULL) {
+	return;
+    }
+    if (fclose(shard_stream) != 0) {
+	fprintf(stderr, "%s: cannot write %s: %s\n",
+		program, shards.shard[shards.nshards-1].name, strerror(errno));
+	exit(9);
+    }
+    shard_stream = NULL;
+    return;
 }
@@ -0,0 +1,778 @@
+/*
+ * bitupdate - set and clear bits of a bitmap file in place
+ *
+ * We will read set and clear operations from stdin and apply them to a
+ * bitmap file in place, without rewriting the rest of the bitmap.  Each
+ * input line is one operation:
+ *
+ *	s value		set the bit of value
+ *	c value		clear the bit of value
+ *
+ * The bitmap represents values as written by bitset, i.e., the bit of
+ * octet 'x' bit 'y' represents start + step*(x*8 + y).  With -w, the
+ * bitmap uses the mod 30 wheel layout (see wheel.h) and step must be 30.
+ * Setting a value beyond the end of the bitmap file extends the file.
+ * When clearing bits leaves 0 octets at the end of the bitmap, they are
+ * dropped, so that as with bitset, the final octet of the bitmap file
+ * has a set bit.  The bitmap file is created if it does not exist.
+ *
+ * The bitmap file is never made shorter in place, as that kills any
+ * process that has it mapped, such as bitmapd.  When 0 octets are
+ * dropped, the shorter bitmap is written to a new file that is renamed
+ * over the bitmap file.
+ *
+ * Setting a value that cannot be represented in the bitmap is reported
+ * on stderr and ignored.  Clearing a value that is < start, that cannot
+ * be represented, or that is beyond the end of the bitmap is silently
+ * ignored because its bit is already 0.
+ *
+ * The bitmap file is mapped into memory.  Operations are applied in
+ * batches of BATCH operations.  Each batch is sorted by value, so that
+ * all the operations on a page of the bitmap are applied together, and
+ * the kernel is told which pages the batch will touch (MADV_WILLNEED)
+ * before any of them is touched.  When the same value appears more than
+ * once in a batch, the last operation wins.  Input sorted by value makes
+ * for batches that touch the fewest pages.
+ *
+ * With -S summary, the summary file of the bitmap (see bitscan.h) is
+ * kept up to date as well: setting a bit sets the summary bit of its
+ * block, and the blocks in which bits were cleared are checked again at
+ * the end of each batch.  The summary file is written after the bitmap.
+ *
+ * With -s, counters of lines read and ignored, bits set and cleared, and
+ * batches applied, along with the wall clock and CPU time spent reading
+ * and updating, are written as JSON on stderr at exit.  The same report
+ * is written when SIGUSR1 is received.
+ *
+ * With -p, the CPU cycles, instructions, branch-misses and last level
+ * cache misses of the update loop, along with cycles per input octet and
+ * instructions per cycle, are written as JSON on stderr at exit.  This
+ * requires Linux hardware performance counters.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <sys/errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "stats.h"
+#include "perfctr.h"
+#include "wheel.h"
+#include "bitscan.h"
+
+
+/*
+ * official version
+ */
+#define VERSION "1.0.0 2026-10-19"          /* format: major.minor YYYY-MM-DD */
+
+
+/*
+ * useful defines
+ */
+#define MAXLINE (1+1+1+19+1)	/* op + space + signed 19 digit value + newline */
+#define OCTETBITS (8)	/* 8 bits per octet */
+#define BATCH (65536)	/* operations applied per batch */
+
+
+/*
+ * usage message
+ */
+static const char * const usage =
+  "usage: %s [-h] [-V] [-s] [-p] [-w] [-S summary] bitmap start step\n"
+        "\n"
+        "    -h            print help message and exit\n"
+        "    -V            print version string and exit\n"
+        "    -s            write stats as JSON on stderr at exit and on SIGUSR1\n"
+        "    -p            write hardware counters of the main loop as JSON on stderr\n"
+        "    -w            use the mod 30 wheel layout (step must be 30)\n"
+        "    -S summary    keep this summary file of the bitmap up to date\n"
+        "\n"
+        "    bitmap        bitmap file to update\n"
+        "    start         starting bitmap value\n"
+        "    step          step values between bits\n"
+        "\n"
+        "    Input lines are: s value (set the bit) or c value (clear the bit)\n"
+        "\n"
+        "Exit codes:\n"
+        "    0         all OK\n"
+        "    2         -h and help string printed or -V and version string printed\n"
+        "    3         command line error\n"
+        "    4         cannot open, map or resize the bitmap file\n"
+        " >= 10        internal error\n"
+        "\n"
+        "%s version: %s\n";
+
+
+/*
+ * static declarations
+ */
+static char *program = NULL;    /* our name */
+static char *prog = NULL;       /* basename of program */
+static const char * const version = VERSION;
+
+/*
+ * bitmap
+ */
+static const char *mapname = NULL;	/* bitmap file name */
+static int mapfd = -1;			/* bitmap file descriptor */
+static u_int8_t *map = NULL;		/* mapped bitmap file, NULL ==> none */
+static unsigned long maplen = 0;	/* octets in the bitmap file */
+static unsigned long start;		/* starting bitmap value */
+static unsigned long step;		/* bitmap increment value */
+static int wheel = 0;			/* 1 ==> -w mod 30 wheel layout */
+static u_int8_t *summary = NULL;	/* summary of bitmap, NULL ==> none */
+static unsigned long pagesize = 0;	/* octets per page of memory */
+
+/*
+ * current batch
+ */
+static struct op {
+    unsigned long bit;		/* bit offset of the value */
+    unsigned long seq;		/* input order, for the last op to win */
+    int set;			/* 1 ==> set, 0 ==> clear */
+} batch[BATCH];
+
+/*
+ * stats counters and phases, see -s
+ */
+static unsigned long long lines_read = 0;		/* input lines read */
+static unsigned long long ignored_invalid = 0;		/* malformed lines */
+static unsigned long long ignored_not_in_bitmap = 0;	/* set of a value != start % step */
+static unsigned long long bits_set = 0;			/* bits changed from 0 to 1 */
+static unsigned long long bits_cleared = 0;		/* bits changed from 1 to 0 */
+static unsigned long long batches = 0;			/* batches applied */
+
+
+/*
+ * static functions
+ */
+static void map_bitmap(unsigned long len);
+static int read_batch(unsigned long long *inbytes);
+static int cmp_op(const void *a, const void *b);
+static void apply_batch(int n);
+static void recheck_block(unsigned long block);
+static void trim_bitmap(void);
+
+
+int
+main(int argc, char *argv[])
+{
+    int n;			/* operations in the current batch */
+    char *sumfile = NULL;	/* -S summary file, NULL ==> none */
+    struct stat sbuf;		/* bitmap file status */
+    unsigned long long inbytes;	/* input octets read */
+    unsigned long long batchbytes;	/* input octets read before this batch */
+    int read_phase;		/* reading operations */
+    int update_phase;		/* updating the bitmap */
+    int i;
+
+    /*
+     * parse args
+     */
+    program = argv[0];
+    prog = rindex(program, '/');
+    if (prog == NULL) {
+        prog = program;
+    } else {
+        ++prog;
+    }
+    while ((i = getopt(argc, argv, ":hVspwS:")) != -1) {
+	switch (i) {
+
+        case 'h':                   /* -h - print help message and exit */
+	    fprintf(stderr, usage, program, prog, version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 'V':                   /* -V - print version string and exit */
+            (void) printf("%s\n", version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 's':                   /* -s - write stats */
+	    stats_setup(prog);
+	    break;
+
+	case 'p':                   /* -p - write hardware counters */
+	    perfctr_setup(prog);
+	    break;
+
+	case 'w':                   /* -w - mod 30 wheel layout */
+	    wheel = 1;
+	    break;
+
+	case 'S':                   /* -S summary - summary file */
+	    sumfile = optarg;
+	    break;
+
+	case ':':
+            (void) fprintf(stderr, "%s: ERROR: requires an argument -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        case '?':
+            (void) fprintf(stderr, "%s: ERROR: illegal option -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        default:
+            fprintf(stderr, "%s: ERROR: invalid -flag\n", program);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+        }
+    }
+    /* skip over command line options */
+    argv += optind;
+    argc -= optind;
+    /* check the arg count */
+    if (argc != 3) {
+        fprintf(stderr, "%s: ERROR: expected 3 args, found: %d\n", program, argc);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+
+    /* parse start */
+    errno = 0;
+    start = strtoll(argv[1], NULL, 0);
+    if (errno == ERANGE) {
+	fprintf(stderr, "%s: failed to parse start value: %s\n", program, argv[1]);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+
+    /* parse step */
+    errno = 0;
+    step = strtoll(argv[2], NULL, 0);
+    if (errno == ERANGE) {
+	fprintf(stderr, "%s: failed to parse step value: %s\n", program, argv[2]);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if ((long)step <= 0) {
+	fprintf(stderr, "%s: step value must be > 0: %s\n", program, argv[2]);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if (wheel && (step != WHEEL_MOD || (long)start % WHEEL_MOD != 0)) {
+	fprintf(stderr, "%s: with -w, step must be %d and start a multiple of %d\n",
+		program, WHEEL_MOD, WHEEL_MOD);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+
+    /*
+     * setup and initialize
+     */
+    pagesize = sysconf(_SC_PAGESIZE);
+    mapname = argv[0];
+    mapfd = open(mapname, O_RDWR|O_CREAT, 0644);
+    if (mapfd < 0 || fstat(mapfd, &sbuf) < 0) {
+	fprintf(stderr, "%s: cannot open %s: %s\n", program, mapname, strerror(errno));
+	exit(4);
+    }
+    map_bitmap(sbuf.st_size);
+    if (sumfile != NULL) {
+	summary = bitscan_load_summary(prog, sumfile, map, maplen, &sbuf);
+    }
+    stats_counter("lines_read", &lines_read);
+    stats_counter("ignored_invalid", &ignored_invalid);
+    stats_counter("ignored_not_in_bitmap", &ignored_not_in_bitmap);
+    stats_counter("bits_set", &bits_set);
+    stats_counter("bits_cleared", &bits_cleared);
+    stats_counter("batches", &batches);
+    read_phase = stats_phase("read");
+    update_phase = stats_phase("update");
+    inbytes = 0;
+    perfctr_start();
+
+    /*
+     * apply batches of operations until EOF
+     */
+    do {
+
+	/*
+	 * read a batch
+	 */
+	if (stats_wanted) {
+	    stats_report(0);
+	}
+	stats_switch(read_phase);
+	batchbytes = inbytes;
+	n = read_batch(&inbytes);
+	stats_bytes(read_phase, inbytes - batchbytes);
+
+	/*
+	 * apply the batch
+	 */
+	stats_switch(update_phase);
+	stats_bytes(update_phase, inbytes - batchbytes);
+	if (n > 0) {
+	    apply_batch(n);
+	    ++batches;
+	}
+
+    } while (n == BATCH);
+
+    /*
+     * drop any 0 octets at the end of the bitmap and write the summary
+     *
+     * A write through the map need not update the modification time of
+     * the bitmap file, so it is set when bits changed.  The summary file
+     * records the final length and modification time of the bitmap file.
+     */
+    trim_bitmap();
+    if (map != NULL && munmap(map, maplen) < 0) {
+	fprintf(stderr, "%s: cannot unmap %s: %s\n", program, mapname, strerror(errno));
+	exit(4);
+    }
+    if ((bits_set + bits_cleared > 0 && futimens(mapfd, NULL) < 0) ||
+	fstat(mapfd, &sbuf) < 0) {
+	fprintf(stderr, "%s: cannot update the time of %s: %s\n",
+		program, mapname, strerror(errno));
+	exit(4);
+    }
+    if (close(mapfd) < 0) {
+	fprintf(stderr, "%s: cannot close %s: %s\n", program, mapname, strerror(errno));
+	exit(4);
+    }
+    if (summary != NULL) {
+	bitscan_save_summary(prog, sumfile, summary, maplen, &sbuf);
+    }
+
+    /*
+     * report hardware counters if -p
+     */
+    perfctr_stop(inbytes);
+
+    /*
+     * report stats if -s
+     */
+    if (stats_on) {
+	stats_switch(-1);
+	stats_report(1);
+    }
+
+    /*
+     * All done!
+     *
+     *	-- Jessica Noll, 1985
+     */
+    exit(0);
+}
+
+
+/*
+ * map_bitmap - resize the bitmap file and map it into memory
+ *
+ * given:
+ *	len	new length of the bitmap file
+ *
+ * The previous mapping, if any, is removed first.  A bitmap file of
+ * length 0 is not mapped.  The summary, if any, grows or shrinks to
+ * match, with the summary bits of new blocks cleared.
+ */
+static void
+map_bitmap(unsigned long len)
+{
+    struct stat sbuf;	/* bitmap file status */
+    void *addr;		/* mapped address */
+    unsigned long oldsum;	/* octets in the old summary */
+
+    if (map != NULL && munmap(map, maplen) < 0) {
+	fprintf(stderr, "%s: cannot unmap %s: %s\n", program, mapname, strerror(errno));
+	exit(4);
+    }
+    map = NULL;
+    if (fstat(mapfd, &sbuf) < 0 ||
+	((unsigned long)sbuf.st_size != len && ftruncate(mapfd, len) < 0)) {
+	fprintf(stderr, "%s: cannot resize %s to %lu octets: %s\n",
+		program, mapname, len, strerror(errno));
+	exit(4);
+    }
+    if (len > 0) {
+	addr = mmap(NULL, len, PROT_READ|PROT_WRITE, MAP_SHARED, mapfd, 0);
+	if (addr == MAP_FAILED) {
+	    fprintf(stderr, "%s: cannot mmap %s: %s\n", program, mapname, strerror(errno));
+	    exit(4);
+	}
+	map = addr;
+    }
+    if (summary != NULL) {
+	oldsum = SUMMARY_LEN(maplen);
+	summary = realloc(summary, SUMMARY_LEN(len) + 1);
+	if (summary == NULL) {
+	    fprintf(stderr, "%s: cannot allocate summary\n", program);
+	    exit(10);
+	}
+	if (SUMMARY_LEN(len) > oldsum) {
+	    memset(summary + oldsum, 0, SUMMARY_LEN(len) - oldsum);
+	}
+    }
+    maplen = len;
+    return;
+}
+
+
+/*
+ * read_batch - read a batch of operations
+ *
+ * given:
+ *	inbytes		add the input octets read to this count
+ *
+ * returns:
+ *	number of operations read into batch[], < BATCH ==> EOF
+ *
+ * Malformed lines, and sets of values that cannot be represented, are
+ * reported on stderr and skipped, as are clears of values whose bit
+ * cannot be set.
+ */
+static int
+read_batch(unsigned long long *inbytes)
+{
+    static char inbuf[MAXLINE+1];	/* max input line + NUL byte */
+    static unsigned long line = 0;	/* input line number */
+    unsigned long value;	/* value of the operation */
+    unsigned long d;		/* value less start */
+    int bit;			/* wheel bit of value, or -1 */
+    int set;			/* 1 ==> set, 0 ==> clear */
+    char *p;			/* char check pointer, NULL ==> malformed */
+    char *q;			/* first digit of value */
+    int n;
+
+    n = 0;
+    clearerr(stdin);
+    while (n < BATCH && fgets(inbuf, MAXLINE+1, stdin) != NULL) {
+	++line;
+	++lines_read;
+
+	/*
+	 * input must be s or c, a space, and an integer (with a possible
+	 * leading -) followed by a newline
+	 */
+	p = NULL;
+	if ((inbuf[0] == 's' || inbuf[0] == 'c') && inbuf[1] == ' ') {
+	    p = inbuf+2;
+	    /* leading - is OK */
+	    if (*p == '-') {
+		++p;
+	    }
+	    q = p;
+	    while (isdigit(*p)) {
+		++p;
+	    }
+	    if (p == q || *p != '\n') {
+		p = NULL;
+	    }
+	}
+	if (p == NULL) {
+	    if (strchr(inbuf, '\n') == NULL && !feof(stdin)) {
+		fprintf(stderr, "%s: line %lu: ignoring, line too long\n", program, line);
+		while (strchr(inbuf, '\n') == NULL) {
+		    if (fgets(inbuf, MAXLINE+1, stdin) == NULL) {
+			break;
+		    }
+		}
+	    } else {
+		fprintf(stderr, "%s: line %lu: ignoring, invalid chars\n", program, line);
+	    }
+	    ++ignored_invalid;
+	    continue;
+	}
+	*inbytes += p+1 - inbuf;
+	set = (inbuf[0] == 's');
+	errno = 0;
+	value = strtoll(inbuf+2, NULL, 0);
+	if (errno == ERANGE) {
+	    fprintf(stderr, "%s: line %lu: ignoring, value out of range\n", program, line);
+	    ++ignored_invalid;
+	    continue;
+	}
+
+	/*
+	 * convert the value into its bit offset
+	 */
+	if (value < start) {
+	    bit = -1;
+	} else {
+	    d = value - start;
+	    if (wheel) {
+		bit = wheel_bit[d % WHEEL_MOD];
+		batch[n].bit = d / WHEEL_MOD * OCTETBITS + bit;
+	    } else {
+		bit = (d % step == 0) ? 0 : -1;
+		batch[n].bit = d / step;
+	    }
+	}
+	if (bit < 0) {
+	    if (set) {
+		fprintf(stderr, "%s: line %lu: ignoring, value not in bitmap\n",
+			program, line);
+		++ignored_not_in_bitmap;
+	    }
+	    continue;
+	}
+	batch[n].seq = line;
+	batch[n].set = set;
+	++n;
+    }
+    if (ferror(stdin)) {
+	fprintf(stderr, "%s: read error: %s\n", program, strerror(errno));
+	exit(6);
+    }
+    return n;
+}
+
+
+/*
+ * cmp_op - compare operations by bit offset, then by input order
+ */
+static int
+cmp_op(const void *a, const void *b)
+{
+    const struct op *x = a;
+    const struct op *y = b;
+
+    if (x->bit != y->bit) {
+	return (x->bit < y->bit) ? -1 : 1;
+    }
+    return (x->seq < y->seq) ? -1 : (x->seq > y->seq);
+}
+
+
+/*
+ * apply_batch - apply a batch of operations to the bitmap
+ *
+ * given:
+ *	n	number of operations in batch[], n > 0
+ */
+static void
+apply_batch(int n)
+{
+    unsigned long need;		/* octets needed by the sets of the batch */
+    unsigned long octet;	/* octet of the operation */
+    unsigned long block;	/* summary block of the operation */
+    unsigned long dirty;	/* block with a cleared bit, or BITSCAN_NONE */
+    u_int8_t mask;		/* bit of the operation within its octet */
+    int i;
+
+    /*
+     * sort the batch so that the operations on each page are together
+     */
+    qsort(batch, n, sizeof(batch[0]), cmp_op);
+
+    /*
+     * extend the bitmap for the highest value set
+     */
+    need = maplen;
+    for (i=n-1; i >= 0; --i) {
+	if (batch[i].set) {
+	    if (batch[i].bit / OCTETBITS >= maplen) {
+		need = batch[i].bit / OCTETBITS + 1;
+	    }
+	    break;
+	}
+    }
+    if (need > maplen) {
+	map_bitmap(need);
+    }
+
+    /*
+     * tell the kernel which pages we are about to touch
+     */
+#if defined(MADV_WILLNEED)
+    {
+	unsigned long page;	/* page of the operation */
+	unsigned long lastpage;	/* last page advised */
+
+	lastpage = BITSCAN_NONE;
+	for (i=0; i < n; ++i) {
+	    page = batch[i].bit / OCTETBITS / pagesize;
+	    if (page != lastpage && page * pagesize < maplen) {
+		(void) madvise(map + page * pagesize, pagesize, MADV_WILLNEED);
+		lastpage = page;
+	    }
+	}
+    }
+#endif
+
+    /*
+     * apply the operations, in order of their bits, the last one winning
+     */
+    dirty = BITSCAN_NONE;
+    for (i=0; i < n; ++i) {
+	if (i+1 < n && batch[i+1].bit == batch[i].bit) {
+	    continue;
+	}
+	octet = batch[i].bit / OCTETBITS;
+	mask = 1 << (batch[i].bit % OCTETBITS);
+	block = octet / SUMMARY_BLOCK;
+	if (batch[i].set) {
+	    if ((map[octet] & mask) == 0) {
+		map[octet] |= mask;
+		++bits_set;
+		if (summary != NULL) {
+		    summary[block / OCTETBITS] |= (1 << (block % OCTETBITS));
+		}
+	    }
+	} else if (octet < maplen && (map[octet] & mask) != 0) {
+	    map[octet] &= ~mask;
+	    ++bits_cleared;
+
+	    /*
+	     * the block of a cleared bit may now be empty
+	     */
+	    if (summary != NULL && map[octet] == 0 && block != dirty) {
+		if (dirty != BITSCAN_NONE) {
+		    recheck_block(dirty);
+		}
+		dirty = block;
+	    }
+	}
+    }
+    if (dirty != BITSCAN_NONE) {
+	recheck_block(dirty);
+    }
+    return;
+}
+
+
+/*
+ * recheck_block - clear the summary bit of a block if it is now empty
+ *
+ * given:
+ *	block	summary block in which bits were cleared
+ */
+static void
+recheck_block(unsigned long block)
+{
+    unsigned long end;		/* octet just beyond the block */
+
+    end = (block+1) * SUMMARY_BLOCK;
+    if (end > maplen) {
+	end = maplen;
+    }
+    if (bitscan_next(map, maplen, block * SUMMARY_BLOCK * OCTETBITS,
+		     end * OCTETBITS) == BITSCAN_NONE) {
+	summary[block / OCTETBITS] &= ~(1 << (block % OCTETBITS));
+    }
+    return;
+}
+
+
+/*
+ * trim_bitmap - drop any 0 octets at the end of the bitmap
+ *
+ * The bitmap file is not truncated in place, as a process that has it
+ * mapped, such as bitmapd, is killed by SIGBUS when it touches a page
+ * beyond the new end.  Instead the octets that remain are written to a
+ * new file in the same directory, which is renamed over the bitmap file
+ * and mapped in its place.  The old file stays intact for any process
+ * that still has it mapped.
+ */
+static void
+trim_bitmap(void)
+{
+    unsigned long len;	/* octets up to and including the last nonzero octet */
+    struct stat sbuf;	/* old bitmap file status */
+    char *tmpname;	/* new bitmap file name */
+    int tmpfd;		/* new bitmap file descriptor */
+    unsigned long off;	/* octets written */
+    ssize_t n;		/* octets written by one write */
+
+    for (len = maplen; len > 0 && map[len-1] == 0; --len) {
+    }
+    if (len == maplen) {
+	return;
+    }
+
+    /*
+     * write the octets that remain to a new file
+     */
+    tmpname = malloc(strlen(mapname) + sizeof(".XXXXXX"));
+    if (tmpname == NULL) {
+	fprintf(stderr, "%s: cannot allocate file name\n", program);
+	exit(10);
+    }
+    sprintf(tmpname, "%s.XXXXXX", mapname);
+    tmpfd = mkstemp(tmpname);
+    if (tmpfd < 0 || fstat(mapfd, &sbuf) < 0 ||
+	fchmod(tmpfd, sbuf.st_mode & 07777) < 0) {
+	fprintf(stderr, "%s: cannot create %s: %s\n", program, tmpname, strerror(errno));
+	exit(4);
+    }
+    for (off = 0; off < len; off += n) {
+	n = write(tmpfd, map + off, len - off);
+	if (n < 0) {
+	    if (errno == EINTR) {
+		n = 0;
+		continue;
+	    }
+	    fprintf(stderr, "%s: cannot write %s: %s\n", program, tmpname, strerror(errno));
+	    (void) unlink(tmpname);
+	    exit(4);
+	}
+    }
+
+    /*
+     * rename the new file over the bitmap file and map it instead
+     */
+    if (rename(tmpname, mapname) < 0) {
+	fprintf(stderr, "%s: cannot rename %s to %s: %s\n",
+		program, tmpname, mapname, strerror(errno));
+	(void) unlink(tmpname);
+	exit(4);
+    }
+    free(tmpname);
+    if (map != NULL && munmap(map, maplen) < 0) {
+	fprintf(stderr, "%s: cannot unmap %s: %s\n", program, mapname, strerror(errno));
+	exit(4);
+    }
+    map = NULL;
+    (void) close(mapfd);
+    mapfd = tmpfd;
+    map_bitmap(len);
+    return;
+}
@@ -4,7 +4,44 @@
  * We will read a bitmap from stdin and list the positions of either 0
  * or 1 bits.
  *
- * Copyright (c) 2001,2015,2023,2025 by Landon Curt Noll.  All Rights Reserved.
+ * With -w, the bitmap uses the mod 30 wheel layout (see wheel.h), where
+ * octet 'x' bit 'y' represents start + 30*x + r[y], and r[] is { 1, 7,
+ * 11, 13, 17, 19, 23, 29 }.  With -w, step must be 30 and start must
+ * be a multiple of 30.
+ *
+ * With -m manifest, the shard files of a bitmap written by bitset -S
+ * (see manifest.h) are listed instead of stdin, and start, step and the
+ * layout come from the manifest.  A shard whose recorded count shows
+ * that it has no bits to list is not read.  The other shards are listed
+ * in parallel, one thread per CPU, each into a temporary file that is
+ * copied to stdout in shard order.
+ *
+ * With -g, instead of listing positions, we write statistics about the
+ * gaps between consecutive listed positions:
+ *
+ *	count N			number of listed positions
+ *	first V			first listed position, if any
+ *	last V			last listed position, if any
+ *	record G V W		gap G from V to W is larger than all earlier gaps
+ *	gap G C			C gaps of size G, for each G that occurs
+ *	gap_over G C		C gaps larger than G (see GAPHIST)
+ *
+ * Gaps are in units of values, i.e., a multiple of step, or for -w, a
+ * difference of values in the wheel.  The record
+ * lines list every gap that is larger than all gaps before it, so the
+ * last record line is the maximal gap.  The bitmap is scanned a 64 bit
+ * word at a time, so long runs of unlisted positions cost little.
+ *
+ * With -s, counters of bytes read and values written, along with the wall
+ * clock and CPU time spent reading and listing, are written as JSON on
+ * stderr at exit.  The same report is written when SIGUSR1 is received.
+ *
+ * With -p, the CPU cycles, instructions, branch-misses and last level
+ * cache misses of the listing loop, along with cycles per bitmap octet
+ * and instructions per cycle, are written as JSON on stderr at exit.
+ * This requires Linux hardware performance counters.
+ *
+ * Copyright (c) 2001,2015,2023,2025,2026 by Landon Curt Noll.  All Rights Reserved.
  *
  * Permission to use, copy, modify, and distribute this software and
  * its documentation for any purpose and without fee is hereby granted,
@@ -39,12 +76,18 @@
 #include <unistd.h>
 #include <string.h>
 #include <sys/errno.h>
+#include <stdint.h>
+
+#include "stats.h"
+#include "perfctr.h"
+#include "wheel.h"
+#include "manifest.h"
 
 
 /*
  * official version
  */
-#define VERSION "1.8.1 2025-04-08"          /* format: major.minor YYYY-MM-DD */
+#define VERSION "1.13.0 2026-10-19"          /* format: major.minor YYYY-MM-DD */
 
 /*
  * what we will count
@@ -52,19 +95,26 @@
 #define COUNT_ZERO (0)	/* count only 0 bits */
 #define COUNT_ONE (1)	/* count only 1 bits */
 #define OCTETBITS (8)	/* 8 bits per octet */
+#define WORDOCTETS (8)	/* octets per 64 bit word */
+#define GAPHIST (1<<20)	/* -g histogram gaps, in units (see gap_unit) */
 
 
 /*
  * usage message
  */
 static const char * const usage =
-  "usage: %s [-h] [-V] start step type\n"
+  "usage: %s [-h] [-V] [-s] [-p] [-g] [-w] [-m manifest] [start step] type\n"
         "\n"
         "    -h            print help message and exit\n"
         "    -V            print version string and exit\n"
+        "    -s            write stats as JSON on stderr at exit and on SIGUSR1\n"
+        "    -p            write hardware counters of the main loop as JSON on stderr\n"
+        "    -g            write gap statistics instead of listing positions\n"
+        "    -w            use the mod 30 wheel layout (step must be 30)\n"
+        "    -m manifest   list the shards of this manifest instead of stdin\n"
         "\n"
-        "    start         starting bitmap value\n"
-        "    step          step values between bits\n"
+        "    start         starting bitmap value (omitted with -m)\n"
+        "    step          step values between bits (omitted with -m)\n"
         "    type          0 ==> list 0 bits, 1 ==> list 1 bits\n"
         "\n"
         "Exit codes:\n"
@@ -88,6 +138,65 @@ static const char * const version = VERSION;
  */
 static u_int8_t buffer[BUFSIZ];
 
+/*
+ * stats counters and phases, see -s
+ */
+static unsigned long long bytes_read = 0;	/* bitmap octets read */
+static unsigned long long values_emitted = 0;	/* values written */
+
+/*
+ * bitmap layout
+ *
+ * Octet 'x' bit 'y' represents the value start + x*octspan + offset[y].
+ */
+static int wheel = 0;			/* 1 ==> -w mod 30 wheel layout */
+static unsigned long octspan = 0;	/* values per octet */
+static unsigned long offset[OCTETBITS];	/* value of bit y less octet value */
+
+/*
+ * gap statistics state, see -g
+ *
+ * Gaps are counted in units: values with -w, else bits, each of which
+ * is step values.
+ */
+static unsigned long long gap_count = 0;	/* listed positions seen */
+static unsigned long long gap_bit = 0;		/* bit offset of next word */
+static unsigned long long gap_first = 0;	/* bit offset of first listed */
+static unsigned long long gap_prev = 0;		/* bit offset of last listed */
+static unsigned long long gap_unit = 0;		/* values per gap unit */
+static unsigned long long gap_max = 0;		/* largest gap, in units */
+static unsigned long long *gap_hist = NULL;	/* gap_hist[g] gaps of g units */
+static unsigned long long gap_over = 0;		/* gaps of >= GAPHIST units */
+static struct record {
+    unsigned long long gap;	/* record gap, in units */
+    unsigned long long from;	/* bit offset at the start of the gap */
+} *gap_record = NULL;				/* record gaps */
+static unsigned long gap_records = 0;		/* record gaps found */
+static unsigned long gap_alloc = 0;		/* record gaps allocated */
+
+/*
+ * manifest mode, see -m
+ */
+static struct manifest *man = NULL;	/* -m manifest, NULL ==> read stdin */
+static int man_type = COUNT_ONE;	/* what we will list in shards */
+static struct result {
+    FILE *stream;		/* listing of the shard, NULL ==> none */
+    unsigned long long values;	/* values listed */
+    unsigned long long octets;	/* octets of the shard read */
+} *result = NULL;			/* result of each shard */
+
+
+/*
+ * static functions
+ */
+static void gap_scan(const u_int8_t *buf, int len, int cnttype);
+static void gap_report(unsigned long start);
+static unsigned long bit_value(unsigned long start, unsigned long long bit);
+static unsigned long long list_octets(FILE *out, const u_int8_t *buf, int len,
+				      int cnttype, unsigned long value);
+static void list_shard(unsigned long i);
+static void emit_shard(unsigned long i);
+
 
 int
 main(int argc, char *argv[])
@@ -97,6 +206,10 @@ main(int argc, char *argv[])
     unsigned long start;	/* starting bitmap value */
     unsigned long step;		/* bitmap increment value */
     unsigned long value;	/* input value from stdin */
+    int read_phase;		/* reading the bitmap */
+    int list_phase;		/* listing bit values */
+    int gflag = 0;		/* 1 ==> -g */
+    char *mfile = NULL;		/* -m manifest file, NULL ==> read stdin */
     int i;
     int j;
 
@@ -110,7 +223,7 @@ main(int argc, char *argv[])
     } else {
         ++prog;
     }
-    while ((i = getopt(argc, argv, ":hV")) != -1) {
+    while ((i = getopt(argc, argv, ":hVspgwm:")) != -1) {
 	switch (i) {
 
         case 'h':                   /* -h - print help message and exit */
@@ -123,6 +236,26 @@ main(int argc, char *argv[])
             exit(2); /* ooo */
             /*NOTREACHED*/
 
+	case 's':                   /* -s - write stats */
+	    stats_setup(prog);
+	    break;
+
+	case 'p':                   /* -p - write hardware counters */
+	    perfctr_setup(prog);
+	    break;
+
+	case 'g':                   /* -g - write gap statistics */
+	    gflag = 1;
+	    break;
+
+	case 'w':                   /* -w - mod 30 wheel layout */
+	    wheel = 1;
+	    break;
+
+	case 'm':                   /* -m manifest - list shards */
+	    mfile = optarg;
+	    break;
+
 	case ':':
             (void) fprintf(stderr, "%s: ERROR: requires an argument -- %c\n", program, optopt);
 	    fprintf(stderr, usage, program, prog, version);
@@ -146,48 +279,74 @@ main(int argc, char *argv[])
     argv += optind;
     argc -= optind;
     /* check the arg count */
-    if (argc != 3) {
-        fprintf(stderr, "%s: ERROR: expected 3 args, found: %d\n", program, argc);
+    if (argc != ((mfile == NULL) ? 3 : 1)) {
+        fprintf(stderr, "%s: ERROR: expected %d args, found: %d\n",
+		program, (mfile == NULL) ? 3 : 1, argc);
 	fprintf(stderr, usage, program, prog, version);
         exit(3); /* ooo */
         /*NOTREACHED*/
     }
-
-    /* parse start */
-    errno = 0;
-    start = strtoll(argv[0], NULL, 0);
-    if (errno == ERANGE) {
-	fprintf(stderr, "%s: failed to parse start value: %s\n", program, argv[0]);
+    if (mfile != NULL && (gflag || wheel)) {
+	fprintf(stderr, "%s: -m conflicts with -g and -w\n", program);
 	fprintf(stderr, usage, program, prog, version);
         exit(3); /* ooo */
         /*NOTREACHED*/
     }
 
-    /* parse step */
-    errno = 0;
-    step = strtoll(argv[1], NULL, 0);
-    if (errno == ERANGE) {
-	fprintf(stderr, "%s: failed to parse step value: %s\n", program, argv[1]);
-	fprintf(stderr, usage, program, prog, version);
-        exit(3); /* ooo */
-        /*NOTREACHED*/
-    }
-    if (step <= 0) {
-	fprintf(stderr, "%s: step value must be > 0: %s\n", program, argv[1]);
-	fprintf(stderr, usage, program, prog, version);
-        exit(3); /* ooo */
-        /*NOTREACHED*/
+    if (mfile != NULL) {
+
+	/* with -m, start, step and the layout come from the manifest */
+	man = manifest_read(prog, mfile);
+	start = man->start;
+	step = man->step;
+	wheel = man->wheel;
+
+    } else {
+
+	/* parse start */
+	errno = 0;
+	start = strtoll(argv[0], NULL, 0);
+	if (errno == ERANGE) {
+	    fprintf(stderr, "%s: failed to parse start value: %s\n", program, argv[0]);
+	    fprintf(stderr, usage, program, prog, version);
+	    exit(3); /* ooo */
+	    /*NOTREACHED*/
+	}
+
+	/* parse step */
+	errno = 0;
+	step = strtoll(argv[1], NULL, 0);
+	if (errno == ERANGE) {
+	    fprintf(stderr, "%s: failed to parse step value: %s\n", program, argv[1]);
+	    fprintf(stderr, usage, program, prog, version);
+	    exit(3); /* ooo */
+	    /*NOTREACHED*/
+	}
+	if (step <= 0) {
+	    fprintf(stderr, "%s: step value must be > 0: %s\n", program, argv[1]);
+	    fprintf(stderr, usage, program, prog, version);
+	    exit(3); /* ooo */
+	    /*NOTREACHED*/
+	}
+	if (wheel && (step != WHEEL_MOD || (long)start % WHEEL_MOD != 0)) {
+	    fprintf(stderr, "%s: with -w, step must be %d and start a multiple of %d\n",
+		    program, WHEEL_MOD, WHEEL_MOD);
+	    fprintf(stderr, usage, program, prog, version);
+	    exit(3); /* ooo */
+	    /*NOTREACHED*/
+	}
+
     }
 
     /* parse type */
-    if (strcmp(argv[2], "0") == 0) {
+    if (strcmp(argv[argc-1], "0") == 0) {
 	cnttype = COUNT_ZERO;
-    } else if (strcmp(argv[2], "1") == 0) {
+    } else if (strcmp(argv[argc-1], "1") == 0) {
 	cnttype = COUNT_ONE;
     } else {
 	fprintf(stderr, "%s: count type: %s must be one of:\n"
 	    "\t0 ==> count 0 bits\n"
-	    "\t1 ==> count 1 bits\n", argv[2], program);
+	    "\t1 ==> count 1 bits\n", argv[argc-1], program);
 	fprintf(stderr, usage, program, prog, version);
         exit(3); /* ooo */
         /*NOTREACHED*/
@@ -197,69 +356,437 @@ main(int argc, char *argv[])
      * setup and initialize
      */
     value = start;
+    if (wheel) {
+	octspan = WHEEL_MOD;
+	for (j=0; j < OCTETBITS; ++j) {
+	    offset[j] = wheel_residue[j];
+	}
+	gap_unit = 1;
+    } else {
+	octspan = OCTETBITS*step;
+	for (j=0; j < OCTETBITS; ++j) {
+	    offset[j] = j*step;
+	}
+	gap_unit = step;
+    }
+    if (gflag) {
+	gap_hist = calloc(GAPHIST, sizeof(gap_hist[0]));
+	if (gap_hist == NULL) {
+	    fprintf(stderr, "%s: cannot allocate gap histogram\n", program);
+	    exit(8);
+	}
+    }
+    stats_counter("bytes_read", &bytes_read);
+    stats_counter("values_emitted", &values_emitted);
+    if (gflag) {
+	stats_counter("positions_counted", &gap_count);
+    }
+    read_phase = stats_phase("read");
+    list_phase = stats_phase("list");
+    perfctr_start();
+
+    /*
+     * with -m, list the shards instead of reading stdin
+     */
+    if (man != NULL) {
+	stats_switch(list_phase);
+	result = calloc(man->nshards, sizeof(result[0]));
+	if (result == NULL) {
+	    fprintf(stderr, "%s: cannot allocate shard results\n", program);
+	    exit(8);
+	}
+	man_type = cnttype;
+	manifest_run(prog, man->nshards, list_shard, emit_shard);
+	stats_bytes(list_phase, bytes_read);
+    }
 
     /*
      * read buffers until EOF
      */
-    do {
+    while (man == NULL && !feof(stdin)) {
 
 	/*
 	 * read a buffer
 	 */
+	if (stats_wanted) {
+	    stats_report(0);
+	}
+	stats_switch(read_phase);
 	clearerr(stdin);
 	readcnt = fread(buffer, 1, BUFSIZ, stdin);
-	if (readcnt == EOF) {
+	if (readcnt == EOF || (readcnt == 0 && feof(stdin))) {
 	    break;	/* EOF found */
 	} else if (readcnt <= 0 || ferror(stdin)) {
 	    fprintf(stderr, "%s: read error: %s\n", program, strerror(errno));
 	    exit(6);
 	}
+	bytes_read += readcnt;
+	stats_bytes(read_phase, readcnt);
+	stats_switch(list_phase);
+	stats_bytes(list_phase, readcnt);
+
+	/*
+	 * gather gap statistics instead of printing bits if -g
+	 */
+	if (gflag) {
+	    gap_scan(buffer, readcnt, cnttype);
+	    continue;
+	}
 
 	/*
 	 * print bits
 	 */
-	switch (cnttype) {
-	case COUNT_ZERO:
-	    for (i=0; i < readcnt; ++i) {
-		if (buffer[i]) {
-		    for (j=0; j < OCTETBITS; ++j) {
-			if ((buffer[i] & (1<<j)) == 0) {
-			    printf("%ld\n", value);
+	values_emitted += list_octets(stdout, buffer, readcnt, cnttype, value);
+	value += readcnt * octspan;
+    }
+
+    /*
+     * write gap statistics if -g
+     */
+    if (gflag) {
+	gap_report(start);
+    }
+
+    /*
+     * report hardware counters if -p
+     */
+    fflush(stdout);
+    perfctr_stop(bytes_read);
+
+    /*
+     * report stats if -s
+     */
+    if (stats_on) {
+	stats_switch(list_phase);
+	fflush(stdout);
+	stats_switch(-1);
+	stats_report(1);
+    }
+
+    /*
+     * All done!
+     *
+     *	-- Jessica Noll, 1985
+     */
+    exit(0);
+}
+
+
+/*
+ * gap_scan - gather gap statistics from a bitmap buffer
+ *
+ * given:
+ *	buf	bitmap buffer
+ *	len	octets in buf
+ *	cnttype	COUNT_ONE ==> 1 bits are listed, COUNT_ZERO ==> 0 bits are listed
+ *
+ * The buffer is scanned a 64 bit word at a time.  Words with no listed
+ * bits are skipped, and within a word each listed bit is found with a
+ * count of trailing zeros.
+ */
+static void
+gap_scan(const u_int8_t *buf, int len, int cnttype)
+{
+    u_int64_t word;		/* 64 bits of buf, bit 0 is lowest position */
+    u_int64_t flip;		/* all 1s ==> list 0 bits, 0 ==> list 1 bits */
+    unsigned long long bit;	/* bit offset of a listed position */
+    unsigned long long gap;	/* bits from previous listed position */
+    int i;
+    int j;
+
+    flip = (cnttype == COUNT_ZERO) ? ~(u_int64_t)0 : 0;
+    for (i=0; i < len; i += WORDOCTETS) {
+
+	/*
+	 * load the next word in bitmap bit order
+	 */
+	if (len - i >= WORDOCTETS) {
+	    memcpy(&word, buf+i, WORDOCTETS);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	    word = __builtin_bswap64(word);
+#endif
+	    word ^= flip;
+	} else {
+	    word = 0;
+	    for (j=0; j < len - i; ++j) {
+		word |= (u_int64_t)(u_int8_t)(buf[i+j] ^ flip) << (j*OCTETBITS);
+	    }
+	}
+
+	/*
+	 * note each listed position in the word
+	 */
+	while (word != 0) {
+	    bit = gap_bit + __builtin_ctzll(word);
+	    word &= word - 1;
+	    if (gap_count == 0) {
+		gap_first = bit;
+	    } else {
+		if (wheel) {
+		    gap = (bit/OCTETBITS - gap_prev/OCTETBITS) * octspan +
+			  offset[bit % OCTETBITS] - offset[gap_prev % OCTETBITS];
+		} else {
+		    gap = bit - gap_prev;
+		}
+		if (gap < GAPHIST) {
+		    ++gap_hist[gap];
+		} else {
+		    ++gap_over;
+		}
+		if (gap > gap_max) {
+		    gap_max = gap;
+		    if (gap_records >= gap_alloc) {
+			gap_alloc = (gap_alloc == 0) ? 64 : 2*gap_alloc;
+			gap_record = realloc(gap_record,
+					     gap_alloc * sizeof(gap_record[0]));
+			if (gap_record == NULL) {
+			    fprintf(stderr, "%s: cannot allocate record gaps\n",
+				    program);
+			    exit(8);
 			}
-			value += step;
 		    }
-		} else {
-		    value += OCTETBITS*step;
+		    gap_record[gap_records].gap = gap;
+		    gap_record[gap_records].from = gap_prev;
+		    ++gap_records;
 		}
 	    }
-	    break;
+	    gap_prev = bit;
+	    ++gap_count;
+	}
+	gap_bit += WORDOCTETS*OCTETBITS;
+    }
 
-	case COUNT_ONE:
-	    for (i=0; i < readcnt; ++i) {
-		if (buffer[i]) {
-		    for (j=0; j < OCTETBITS; ++j) {
-			if ((buffer[i] & (1<<j)) != 0) {
-			    printf("%ld\n", value);
-			}
-			value += step;
+    /*
+     * a partial word only happens at the end of the bitmap, but keep
+     * bit offsets exact anyway
+     */
+    if (len % WORDOCTETS != 0) {
+	gap_bit -= (WORDOCTETS - len % WORDOCTETS) * OCTETBITS;
+    }
+    return;
+}
+
+
+/*
+ * gap_report - write gap statistics
+ *
+ * given:
+ *	start	starting bitmap value
+ */
+static void
+gap_report(unsigned long start)
+{
+    unsigned long from;		/* value at the start of a record gap */
+    unsigned long g;
+    unsigned long r;
+
+    clearerr(stdout);
+    printf("count %llu\n", gap_count);
+    if (gap_count > 0) {
+	printf("first %ld\n", bit_value(start, gap_first));
+	printf("last %ld\n", bit_value(start, gap_prev));
+    }
+    for (r=0; r < gap_records; ++r) {
+	from = bit_value(start, gap_record[r].from);
+	printf("record %llu %ld %ld\n",
+	       gap_record[r].gap * gap_unit, from,
+	       (unsigned long)(from + gap_record[r].gap * gap_unit));
+    }
+    for (g=1; g < GAPHIST; ++g) {
+	if (gap_hist[g] > 0) {
+	    printf("gap %llu %llu\n", g * gap_unit, gap_hist[g]);
+	}
+    }
+    if (gap_over > 0) {
+	printf("gap_over %llu %llu\n", (GAPHIST-1) * gap_unit, gap_over);
+    }
+    if (fflush(stdout) != 0 || ferror(stdout)) {
+	fprintf(stderr, "%s: write error: %s\n", program, strerror(errno));
+	exit(9);
+    }
+    return;
+}
+
+
+/*
+ * bit_value - value represented by a bit of the bitmap
+ *
+ * given:
+ *	start	starting bitmap value
+ *	bit	bit offset from the beginning of the bitmap
+ *
+ * returns:
+ *	value represented by bit
+ */
+static unsigned long
+bit_value(unsigned long start, unsigned long long bit)
+{
+    return start + (bit / OCTETBITS) * octspan + offset[bit % OCTETBITS];
+}
+
+
+/*
+ * list_octets - list the positions of 0 or 1 bits of a bitmap buffer
+ *
+ * given:
+ *	out	where to list
+ *	buf	bitmap buffer
+ *	len	octets in buf
+ *	cnttype	COUNT_ONE ==> list 1 bits, COUNT_ZERO ==> list 0 bits
+ *	value	value of octet 0 bit 0 of buf
+ *
+ * returns:
+ *	number of values listed
+ */
+static unsigned long long
+list_octets(FILE *out, const u_int8_t *buf, int len, int cnttype, unsigned long value)
+{
+    unsigned long long cnt = 0;	/* values listed */
+    int i;
+    int j;
+
+    switch (cnttype) {
+    case COUNT_ZERO:
+	for (i=0; i < len; ++i) {
+	    if (buf[i] != 0xff) {
+		for (j=0; j < OCTETBITS; ++j) {
+		    if ((buf[i] & (1<<j)) == 0) {
+			fprintf(out, "%ld\n", value + offset[j]);
+			++cnt;
 		    }
-		} else {
-		    value += OCTETBITS*step;
 		}
 	    }
-	    break;
+	    value += octspan;
+	}
+	break;
 
-        default:
-	    fprintf(stderr, "%s: invalid cnttype: %d\n", program, cnttype);
-	    exit(7);
+    case COUNT_ONE:
+	for (i=0; i < len; ++i) {
+	    if (buf[i]) {
+		for (j=0; j < OCTETBITS; ++j) {
+		    if ((buf[i] & (1<<j)) != 0) {
+			fprintf(out, "%ld\n", value + offset[j]);
+			++cnt;
+		    }
+		}
+	    }
+	    value += octspan;
 	}
+	break;
 
-    } while (!feof(stdin));
+    default:
+	fprintf(stderr, "%s: invalid cnttype: %d\n", program, cnttype);
+	exit(7);
+    }
+    return cnt;
+}
+
+
+/*
+ * list_shard - list a shard into a temporary file
+ *
+ * given:
+ *	i	shard to list
+ *
+ * This is called from a shard thread, so it leaves stdout and the stats
+ * alone.  A shard with no bits to list is not read.
+ */
+static void
+list_shard(unsigned long i)
+{
+    struct shard *s = &man->shard[i];	/* shard to list */
+    struct result *r = &result[i];	/* listing of the shard */
+    unsigned long long left;	/* octets of the shard left to read */
+    unsigned long value;	/* value of the octet being read */
+    u_int8_t *buf;		/* read buffer */
+    FILE *stream;		/* open shard file */
+    size_t len;			/* octets to read */
 
     /*
-     * All done!
-     *
-     *	-- Jessica Noll, 1985
+     * skip a shard with no bits to list
      */
-    exit(0);
+    if (s->octets == 0 ||
+	(man_type == COUNT_ONE && s->count == 0) ||
+	(man_type == COUNT_ZERO && s->count == s->octets * OCTETBITS)) {
+	return;
+    }
+
+    /*
+     * list the shard file, a buffer at a time
+     */
+    buf = malloc(BUFSIZ);
+    if (buf == NULL) {
+	fprintf(stderr, "%s: cannot allocate shard buffer\n", program);
+	exit(8);
+    }
+    r->stream = tmpfile();
+    if (r->stream == NULL) {
+	fprintf(stderr, "%s: cannot create temporary file: %s\n", program, strerror(errno));
+	exit(9);
+    }
+    stream = fopen(s->name, "r");
+    if (stream == NULL) {
+	fprintf(stderr, "%s: cannot open shard %s: %s\n", program, s->name, strerror(errno));
+	exit(6);
+    }
+    value = s->first;
+    for (left = s->octets; left > 0; left -= len) {
+	len = (left < BUFSIZ) ? left : BUFSIZ;
+	if (fread(buf, 1, len, stream) != len) {
+	    fprintf(stderr, "%s: shard %s is shorter than its manifest length\n",
+		    program, s->name);
+	    exit(6);
+	}
+	r->values += list_octets(r->stream, buf, len, man_type, value);
+	value += len * octspan;
+    }
+    r->octets = s->octets;
+    if (fflush(r->stream) != 0 || ferror(r->stream)) {
+	fprintf(stderr, "%s: write error on temporary file: %s\n", program, strerror(errno));
+	exit(9);
+    }
+    (void) fclose(stream);
+    free(buf);
+    return;
+}
+
+
+/*
+ * emit_shard - copy the listing of a shard to stdout
+ *
+ * given:
+ *	i	shard whose listing to copy
+ *
+ * This is called in shard order.
+ */
+static void
+emit_shard(unsigned long i)
+{
+    struct result *r = &result[i];	/* listing of the shard */
+    char buf[BUFSIZ];		/* copy buffer */
+    size_t len;			/* octets read */
+
+    if (stats_wanted) {
+	stats_report(0);
+    }
+    bytes_read += r->octets;
+    values_emitted += r->values;
+    if (r->stream == NULL) {
+	return;
+    }
+    rewind(r->stream);
+    clearerr(stdout);
+    while ((len = fread(buf, 1, BUFSIZ, r->stream)) > 0) {
+	if (fwrite(buf, 1, len, stdout) != len) {
+	    fprintf(stderr, "%s: write error: %s\n", program, strerror(errno));
+	    exit(9);
+	}
+    }
+    if (ferror(r->stream)) {
+	fprintf(stderr, "%s: read error on temporary file: %s\n", program, strerror(errno));
+	exit(9);
+    }
+    (void) fclose(r->stream);
+    r->stream = NULL;
+    return;
 }
@@ -0,0 +1,413 @@
+/*
+ * manifest - manifest of a bitmap written as shard files
+ *
+ * manifest_run() runs a work function on every shard with a pool of
+ * threads, one per online CPU, and an emit function on every shard in
+ * shard order in the calling thread.  Workers never get more than
+ * RUN_AHEAD shards per thread ahead of the shard being emitted, so the
+ * results waiting to be emitted stay bounded.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "manifest.h"
+#include "wheel.h"
+
+
+/*
+ * useful defines
+ */
+#define MANIFEST_MAXLINE (4096)	/* max manifest line, without the NUL byte */
+#define RUN_AHEAD (2)		/* shards per thread run ahead of emit */
+#define OCTETBITS (8)		/* 8 bits per octet */
+
+
+/*
+ * manifest_run state, shared by the calling thread and the workers
+ */
+static pthread_mutex_t run_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t run_cond = PTHREAD_COND_INITIALIZER;
+static unsigned long run_nshards = 0;	/* shards to run */
+static unsigned long run_next = 0;	/* next shard to work on */
+static unsigned long run_emitted = 0;	/* shards emitted */
+static unsigned long run_window = 0;	/* max shards worked ahead of emit */
+static u_int8_t *run_done = NULL;	/* run_done[i] != 0 ==> shard i worked */
+static void (*run_work)(unsigned long) = NULL;	/* work function */
+
+
+/*
+ * static functions
+ */
+static void bad_manifest(const char *prog, const char *filename,
+			 unsigned long line, const char *msg);
+static void *run_worker(void *arg);
+
+
+/*
+ * manifest_read - read a manifest
+ *
+ * given:
+ *	prog		program name for errors
+ *	filename	manifest file
+ *
+ * returns:
+ *	manifest, with shard file names found from the manifest directory
+ *
+ * A manifest that cannot be read, or whose shards do not follow one
+ * another as bitset writes them, is a fatal error.
+ */
+struct manifest *
+manifest_read(const char *prog, const char *filename)
+{
+    static char buf[MANIFEST_MAXLINE+1];	/* manifest line + NUL byte */
+    static char name[MANIFEST_MAXLINE+1];	/* shard file name */
+    FILE *stream;		/* open manifest */
+    struct manifest *m;		/* manifest read */
+    struct shard *s;		/* shard being read or checked */
+    const char *slash;		/* last / of filename, NULL ==> none */
+    size_t dirlen;		/* octets of the manifest directory */
+    size_t n;			/* octets of directory to put before a shard */
+    unsigned long line;		/* manifest line number */
+    unsigned long alloc;	/* shards allocated */
+    long long first;		/* value of bit 0 of the shard */
+    unsigned long long octets;	/* octets in the shard file */
+    unsigned long long count;	/* 1 bits in the shard file */
+    long long value;		/* value of a start or step line */
+    int have;			/* start, step, wheel and shard_bits lines found */
+    unsigned long i;
+
+    /*
+     * open the manifest
+     */
+    stream = fopen(filename, "r");
+    if (stream == NULL) {
+	fprintf(stderr, "%s: cannot open manifest %s: %s\n",
+		prog, filename, strerror(errno));
+	exit(15);
+    }
+    m = calloc(1, sizeof(*m));
+    if (m == NULL) {
+	fprintf(stderr, "%s: cannot allocate manifest\n", prog);
+	exit(15);
+    }
+    slash = strrchr(filename, '/');
+    dirlen = (slash == NULL) ? 0 : slash+1 - filename;
+
+    /*
+     * read each line
+     */
+    have = 0;
+    alloc = 0;
+    for (line = 1; fgets(buf, MANIFEST_MAXLINE+1, stream) != NULL; ++line) {
+	if (strchr(buf, '\n') == NULL && !feof(stream)) {
+	    bad_manifest(prog, filename, line, "line too long");
+	}
+	if (buf[0] == '#' || buf[0] == '\n') {
+	    continue;
+	}
+	if (sscanf(buf, "start %lld", &value) == 1) {
+	    m->start = value;
+	    have |= 1;
+	} else if (sscanf(buf, "step %lld", &value) == 1) {
+	    if (value <= 0) {
+		bad_manifest(prog, filename, line, "step must be > 0");
+	    }
+	    m->step = value;
+	    have |= 2;
+	} else if (sscanf(buf, "wheel %d", &m->wheel) == 1) {
+	    if (m->wheel != 0 && m->wheel != 1) {
+		bad_manifest(prog, filename, line, "wheel must be 0 or 1");
+	    }
+	    have |= 4;
+	} else if (sscanf(buf, "shard_bits %llu", &m->shard_bits) == 1) {
+	    if (m->shard_bits == 0 || m->shard_bits % OCTETBITS != 0) {
+		bad_manifest(prog, filename, line, "shard_bits must be a multiple of 8");
+	    }
+	    have |= 8;
+	} else if (sscanf(buf, "shard %s %lld %llu %llu",
+			  name, &first, &octets, &count) == 4) {
+	    if (m->nshards >= alloc) {
+		alloc = (alloc == 0) ? 64 : 2*alloc;
+		m->shard = realloc(m->shard, alloc * sizeof(m->shard[0]));
+		if (m->shard == NULL) {
+		    fprintf(stderr, "%s: cannot allocate manifest shards\n", prog);
+		    exit(15);
+		}
+	    }
+	    s = &m->shard[m->nshards++];
+	    s->first = first;
+	    s->octets = octets;
+	    s->count = count;
+	    n = (name[0] == '/') ? 0 : dirlen;
+	    s->name = malloc(n + strlen(name) + 1);
+	    if (s->name == NULL) {
+		fprintf(stderr, "%s: cannot allocate shard name\n", prog);
+		exit(15);
+	    }
+	    memcpy(s->name, filename, n);
+	    strcpy(s->name + n, name);
+	} else {
+	    bad_manifest(prog, filename, line, "unknown line");
+	}
+    }
+    if (ferror(stream)) {
+	fprintf(stderr, "%s: read error on manifest %s: %s\n",
+		prog, filename, strerror(errno));
+	exit(15);
+    }
+    (void) fclose(stream);
+    if (have != (1|2|4|8)) {
+	fprintf(stderr, "%s: manifest %s: missing start, step, wheel or shard_bits\n",
+		prog, filename);
+	exit(15);
+    }
+    if (m->wheel && (m->step != WHEEL_MOD || (long)m->start % WHEEL_MOD != 0)) {
+	fprintf(stderr, "%s: manifest %s: with wheel, step must be %d and start a multiple of %d\n",
+		prog, filename, WHEEL_MOD, WHEEL_MOD);
+	exit(15);
+    }
+
+    /*
+     * check that the shards follow one another
+     */
+    for (i=0; i < m->nshards; ++i) {
+	s = &m->shard[i];
+	s->bit = i * m->shard_bits;
+	if (m->wheel) {
+	    first = m->start + s->bit / OCTETBITS * WHEEL_MOD;
+	} else {
+	    first = m->start + s->bit * m->step;
+	}
+	if (s->first != (unsigned long)first) {
+	    fprintf(stderr, "%s: manifest %s: shard %s: first value %ld, expected %lld\n",
+		    prog, filename, s->name, s->first, first);
+	    exit(15);
+	}
+	if (s->octets * OCTETBITS > m->shard_bits ||
+	    (i < m->nshards-1 && s->octets * OCTETBITS != m->shard_bits)) {
+	    fprintf(stderr, "%s: manifest %s: shard %s: wrong length: %llu octets\n",
+		    prog, filename, s->name, s->octets);
+	    exit(15);
+	}
+	if (s->count > s->octets * OCTETBITS) {
+	    fprintf(stderr, "%s: manifest %s: shard %s: count %llu > %llu bits\n",
+		    prog, filename, s->name, s->count, s->octets * OCTETBITS);
+	    exit(15);
+	}
+    }
+    return m;
+}
+
+
+/*
+ * manifest_write - write a manifest
+ *
+ * given:
+ *	prog		program name for errors
+ *	filename	manifest file
+ *	m		manifest to write
+ *
+ * The shard file names are written as they are, so they should be
+ * relative to the directory of filename.
+ */
+void
+manifest_write(const char *prog, const char *filename, const struct manifest *m)
+{
+    FILE *stream;	/* open manifest */
+    unsigned long i;
+
+    stream = fopen(filename, "w");
+    if (stream == NULL) {
+	fprintf(stderr, "%s: cannot create manifest %s: %s\n",
+		prog, filename, strerror(errno));
+	exit(15);
+    }
+    fprintf(stream, "# bitmap shard manifest\n");
+    fprintf(stream, "start %ld\n", m->start);
+    fprintf(stream, "step %ld\n", m->step);
+    fprintf(stream, "wheel %d\n", m->wheel);
+    fprintf(stream, "shard_bits %llu\n", m->shard_bits);
+    fprintf(stream, "# shard file first octets count\n");
+    for (i=0; i < m->nshards; ++i) {
+	fprintf(stream, "shard %s %ld %llu %llu\n", m->shard[i].name,
+		m->shard[i].first, m->shard[i].octets, m->shard[i].count);
+    }
+    if (ferror(stream) || fclose(stream) != 0) {
+	fprintf(stderr, "%s: write error on manifest %s: %s\n",
+		prog, filename, strerror(errno));
+	exit(15);
+    }
+    return;
+}
+
+
+/*
+ * manifest_run - work on shards in parallel, emit them in order
+ *
+ * given:
+ *	prog		program name for errors
+ *	nshards		number of shards
+ *	work		called once per shard, from a worker thread
+ *	emit		called once per shard, in shard order, from this thread
+ *
+ * emit(i) is called only after work(i) returns.  work() must not use
+ * stdio streams shared with emit(), nor the stats or perfctr state.
+ */
+void
+manifest_run(const char *prog, unsigned long nshards,
+	     void (*work)(unsigned long), void (*emit)(unsigned long))
+{
+    pthread_t *thread;		/* worker threads */
+    long nthreads;		/* number of worker threads */
+    unsigned long i;
+    int ret;
+
+    /*
+     * setup
+     */
+    if (nshards == 0) {
+	return;
+    }
+    nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads < 1) {
+	nthreads = 1;
+    } else if ((unsigned long)nthreads > nshards) {
+	nthreads = nshards;
+    }
+    run_done = calloc(nshards, 1);
+    thread = calloc(nthreads, sizeof(thread[0]));
+    if (run_done == NULL || thread == NULL) {
+	fprintf(stderr, "%s: cannot allocate shard threads\n", prog);
+	exit(15);
+    }
+    run_nshards = nshards;
+    run_next = 0;
+    run_emitted = 0;
+    run_window = RUN_AHEAD * nthreads;
+    run_work = work;
+
+    /*
+     * start the workers
+     */
+    for (i=0; i < (unsigned long)nthreads; ++i) {
+	ret = pthread_create(&thread[i], NULL, run_worker, NULL);
+	if (ret != 0) {
+	    fprintf(stderr, "%s: cannot create shard thread: %s\n", prog, strerror(ret));
+	    exit(15);
+	}
+    }
+
+    /*
+     * emit each shard as soon as it and all shards before it are done
+     */
+    for (i=0; i < nshards; ++i) {
+	pthread_mutex_lock(&run_lock);
+	while (run_done[i] == 0) {
+	    pthread_cond_wait(&run_cond, &run_lock);
+	}
+	pthread_mutex_unlock(&run_lock);
+	emit(i);
+	pthread_mutex_lock(&run_lock);
+	run_emitted = i+1;
+	pthread_cond_broadcast(&run_cond);
+	pthread_mutex_unlock(&run_lock);
+    }
+
+    /*
+     * cleanup
+     */
+    for (i=0; i < (unsigned long)nthreads; ++i) {
+	pthread_join(thread[i], NULL);
+    }
+    free(thread);
+    free(run_done);
+    run_done = NULL;
+    return;
+}
+
+
+/*
+ * bad_manifest - report a malformed manifest line and exit
+ *
+ * given:
+ *	prog		program name for errors
+ *	filename	manifest file
+ *	line		manifest line number
+ *	msg		what is wrong
+ */
+static void
+bad_manifest(const char *prog, const char *filename, unsigned long line, const char *msg)
+{
+    fprintf(stderr, "%s: manifest %s: line %lu: %s\n", prog, filename, line, msg);
+    exit(15);
+}
+
+
+/*
+ * run_worker - work on shards until none are left
+ *
+ * given:
+ *	arg		unused
+ *
+ * returns:
+ *	NULL
+ */
+static void *
+run_worker(void *arg)
+{
+    unsigned long i;	/* shard to work on */
+
+    for (;;) {
+	pthread_mutex_lock(&run_lock);
+	while (run_next < run_nshards && run_next >= run_emitted + run_window) {
+	    pthread_cond_wait(&run_cond, &run_lock);
+	}
+	if (run_next >= run_nshards) {
+	    pthread_mutex_unlock(&run_lock);
+	    return NULL;
+	}
+	i = run_next++;
+	pthread_mutex_unlock(&run_lock);
+
+	run_work(i);
+
+	pthread_mutex_lock(&run_lock);
+	run_done[i] = 1;
+	pthread_cond_broadcast(&run_cond);
+	pthread_mutex_unlock(&run_lock);
+    }
+}
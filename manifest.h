@@ -0,0 +1,100 @@
+/*
+ * manifest - manifest of a bitmap written as shard files
+ *
+ * With -S bits -o prefix, bitset writes its bitmap as a series of shard
+ * files, prefix.000000, prefix.000001, ..., each holding the next bits
+ * bits of the bitmap, and a manifest, prefix.manifest, that describes
+ * them.  Each shard is itself a bitmap with the same step (or wheel
+ * layout), and the shard files concatenated in order are the bitmap
+ * that bitset would otherwise have written.  Every shard but the last
+ * is exactly bits/8 octets long.
+ *
+ * A manifest is a text file of lines:
+ *
+ *	start value		starting value of the whole bitmap
+ *	step value		step values between bits
+ *	wheel 0|1		1 ==> mod 30 wheel layout (see wheel.h)
+ *	shard_bits bits		bits per shard, a multiple of 8
+ *	shard file first octets count
+ *
+ * followed by one shard line per shard, in order.  For each shard, first
+ * is the value of its bit 0 (its start value), octets is the length of
+ * the shard file and count is the number of 1 bits in it.  A shard file
+ * name that does not begin with / is relative to the directory of the
+ * manifest.  Lines beginning with # are comments.
+ *
+ * The recorded counts let popcnt and listbit skip any shard whose count
+ * already answers the question, such as a shard with no 1 bits when
+ * listing 1 bits.  manifest_run() lets them process the other shards in
+ * parallel, while their results are still written in shard order.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#if !defined(INCLUDE_MANIFEST_H)
+#define INCLUDE_MANIFEST_H
+
+#include <sys/types.h>
+
+
+/*
+ * a shard of a bitmap
+ */
+struct shard {
+    char *name;			/* shard file, as found from the manifest */
+    unsigned long first;	/* value of bit 0 of the shard */
+    unsigned long long bit;	/* bit offset of the shard in the bitmap */
+    unsigned long long octets;	/* octets in the shard file */
+    unsigned long long count;	/* 1 bits in the shard file */
+};
+
+/*
+ * a bitmap written as shards
+ */
+struct manifest {
+    unsigned long start;	/* starting bitmap value */
+    unsigned long step;		/* bitmap increment value */
+    int wheel;			/* 1 ==> mod 30 wheel layout */
+    unsigned long long shard_bits;	/* bits per shard, the last may be fewer */
+    unsigned long nshards;	/* shards in the bitmap */
+    struct shard *shard;	/* the shards, in bitmap order */
+};
+
+
+/*
+ * external functions
+ */
+extern struct manifest *manifest_read(const char *prog, const char *filename);
+extern void manifest_write(const char *prog, const char *filename,
+			   const struct manifest *m);
+extern void manifest_run(const char *prog, unsigned long nshards,
+			 void (*work)(unsigned long), void (*emit)(unsigned long));
+
+
+#endif /* INCLUDE_MANIFEST_H */
@@ -0,0 +1,277 @@
+/*
+ * perfctr - hardware performance counters around a processing loop
+ *
+ * A tool calls perfctr_start() just before its main processing loop and
+ * perfctr_stop() just after it.  The cycles, instructions, branch-misses
+ * and last level cache misses of the loop, along with derived metrics,
+ * are written as a single line of JSON on stderr:
+ *
+ *	{"program":"popcnt","perf":{"cycles":1234,"instructions":5678,
+ *	 "branch_misses":12,"llc_misses":34,"bytes":8192,
+ *	 "cycles_per_byte":0.150635,"ipc":4.601297,
+ *	 "branch_misses_per_kb":1.500000,"llc_misses_per_kb":4.250000}}
+ *
+ * all on a single line.  Only user space is counted.  A counter that the
+ * kernel or the CPU does not support is reported as null.  Counts are
+ * scaled when the kernel had to multiplex the counters.
+ *
+ * The counters are inherited by the threads a tool starts after
+ * perfctr_setup(), such as the shard threads of -m, and the counts of a
+ * thread are added in when it ends.  So the threads of a loop must be
+ * joined before perfctr_stop() for the counts to cover all of its work.
+ * The kernel cannot inherit counters read with PERF_FORMAT_GROUP, so
+ * each counter is read on its own.
+ *
+ * Hardware counters are read with perf_event_open(2) and thus are only
+ * available on Linux.  Elsewhere, or when perf_event_paranoid does not
+ * allow us, a warning is written and no counters are reported.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "perfctr.h"
+
+
+/*
+ * counters we will use
+ */
+#define PERFCTR_CYCLES (0)	/* CPU cycles, the group leader */
+#define PERFCTR_INSNS (1)	/* instructions retired */
+#define PERFCTR_BRMISS (2)	/* mispredicted branches */
+#define PERFCTR_LLCMISS (3)	/* last level cache misses */
+#define PERFCTR_MAX (4)		/* number of counters */
+
+
+/*
+ * static declarations
+ */
+static const char *report_name = NULL;	/* program name to report, NULL ==> off */
+static int fd[PERFCTR_MAX] = { -1, -1, -1, -1 };	/* counter fds, -1 ==> none */
+static int setup_done = 0;	/* 1 ==> perfctr_setup() already called */
+static const char * const counter_name[PERFCTR_MAX] = {
+    "cycles", "instructions", "branch_misses", "llc_misses"
+};
+
+
+#if defined(__linux__)
+/*
+ * open_counter - open a user space hardware counter
+ *
+ * given:
+ *	config	PERF_COUNT_HW_* counter
+ *	leader	group leader fd, or -1 ==> this is the group leader
+ *
+ * returns:
+ *	counter fd, or -1 ==> counter not available
+ */
+static int
+open_counter(unsigned long long config, int leader)
+{
+    struct perf_event_attr attr;	/* what to count */
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = (leader < 0);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+		       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+}
+#endif
+
+
+/*
+ * perfctr_setup - enable hardware performance counters
+ *
+ * Only the first call opens the counters, so a repeated -p does not
+ * open another counter group or warn again.
+ *
+ * given:
+ *	prog	program name to report
+ */
+void
+perfctr_setup(const char *prog)
+{
+    if (setup_done) {
+	return;
+    }
+    setup_done = 1;
+#if defined(__linux__)
+    fd[PERFCTR_CYCLES] = open_counter(PERF_COUNT_HW_CPU_CYCLES, -1);
+    if (fd[PERFCTR_CYCLES] < 0) {
+	fprintf(stderr, "%s: WARNING: hardware counters not available: %s\n",
+		prog, strerror(errno));
+	return;
+    }
+    fd[PERFCTR_INSNS] = open_counter(PERF_COUNT_HW_INSTRUCTIONS,
+				     fd[PERFCTR_CYCLES]);
+    fd[PERFCTR_BRMISS] = open_counter(PERF_COUNT_HW_BRANCH_MISSES,
+				      fd[PERFCTR_CYCLES]);
+    fd[PERFCTR_LLCMISS] = open_counter(PERF_COUNT_HW_CACHE_MISSES,
+				       fd[PERFCTR_CYCLES]);
+    report_name = prog;
+#else
+    fprintf(stderr, "%s: WARNING: hardware counters not supported on "
+		    "this platform\n", prog);
+#endif
+    return;
+}
+
+
+/*
+ * perfctr_start - start counting
+ */
+void
+perfctr_start(void)
+{
+#if defined(__linux__)
+    if (report_name == NULL) {
+	return;
+    }
+    ioctl(fd[PERFCTR_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fd[PERFCTR_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    return;
+}
+
+
+/*
+ * perfctr_stop - stop counting and report counters as JSON on stderr
+ *
+ * given:
+ *	bytes	bytes processed by the loop, 0 ==> no per byte metrics
+ */
+void
+perfctr_stop(unsigned long long bytes)
+{
+#if defined(__linux__)
+    unsigned long long val[3];	/* count, time enabled, time running */
+    double count[PERFCTR_MAX];	/* scaled counts, < 0 ==> not available */
+    const char *p;
+    int i;
+
+    if (report_name == NULL) {
+	return;
+    }
+    ioctl(fd[PERFCTR_CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    /*
+     * read and scale each counter
+     */
+    for (i=0; i < PERFCTR_MAX; ++i) {
+	count[i] = -1.0;
+	if (fd[i] < 0 || read(fd[i], val, sizeof(val)) != sizeof(val)) {
+	    continue;
+	}
+	if (val[2] == 0) {
+	    count[i] = 0.0;
+	} else {
+	    count[i] = (double)val[0] * ((double)val[1] / (double)val[2]);
+	}
+    }
+
+    /*
+     * counters
+     */
+    fputs("{\"program\":\"", stderr);
+    for (p = report_name; *p != '\0'; ++p) {
+	if (*p == '"' || *p == '\\') {
+	    putc('\\', stderr);
+	}
+	putc(*p, stderr);
+    }
+    fputs("\",\"perf\":{", stderr);
+    for (i=0; i < PERFCTR_MAX; ++i) {
+	if (count[i] < 0.0) {
+	    fprintf(stderr, "\"%s\":null,", counter_name[i]);
+	} else {
+	    fprintf(stderr, "\"%s\":%.0f,", counter_name[i], count[i]);
+	}
+    }
+    fprintf(stderr, "\"bytes\":%llu", bytes);
+
+    /*
+     * derived metrics
+     */
+    if (bytes > 0 && count[PERFCTR_CYCLES] >= 0.0) {
+	fprintf(stderr, ",\"cycles_per_byte\":%.6f",
+		count[PERFCTR_CYCLES] / (double)bytes);
+    } else {
+	fputs(",\"cycles_per_byte\":null", stderr);
+    }
+    if (count[PERFCTR_INSNS] >= 0.0 && count[PERFCTR_CYCLES] > 0.0) {
+	fprintf(stderr, ",\"ipc\":%.6f",
+		count[PERFCTR_INSNS] / count[PERFCTR_CYCLES]);
+    } else {
+	fputs(",\"ipc\":null", stderr);
+    }
+    if (bytes > 0 && count[PERFCTR_BRMISS] >= 0.0) {
+	fprintf(stderr, ",\"branch_misses_per_kb\":%.6f",
+		count[PERFCTR_BRMISS] * 1024.0 / (double)bytes);
+    } else {
+	fputs(",\"branch_misses_per_kb\":null", stderr);
+    }
+    if (bytes > 0 && count[PERFCTR_LLCMISS] >= 0.0) {
+	fprintf(stderr, ",\"llc_misses_per_kb\":%.6f",
+		count[PERFCTR_LLCMISS] * 1024.0 / (double)bytes);
+    } else {
+	fputs(",\"llc_misses_per_kb\":null", stderr);
+    }
+    fputs("}}\n", stderr);
+    fflush(stderr);
+
+    /*
+     * close counters
+     */
+    for (i=0; i < PERFCTR_MAX; ++i) {
+	if (fd[i] >= 0) {
+	    close(fd[i]);
+	    fd[i] = -1;
+	}
+    }
+    report_name = NULL;
+#endif
+    return;
+}
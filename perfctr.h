@@ -0,0 +1,50 @@
+/*
+ * perfctr - hardware performance counters around a processing loop
+ *
+ * A tool calls perfctr_start() just before its main processing loop and
+ * perfctr_stop() just after it.  The cycles, instructions, branch-misses
+ * and last level cache misses of the loop, along with derived metrics,
+ * are written as a single line of JSON on stderr.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#if !defined(INCLUDE_PERFCTR_H)
+#define INCLUDE_PERFCTR_H
+
+
+/*
+ * external functions
+ */
+extern void perfctr_setup(const char *prog);
+extern void perfctr_start(void);
+extern void perfctr_stop(unsigned long long bytes);
+
+
+#endif /* INCLUDE_PERFCTR_H */
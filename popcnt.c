@@ -4,7 +4,37 @@
  * We will read a bitmap from stdin and count bits.  The count will
  * be written to stdout.
  *
- * Copyright (c) 2001,2015,2023,2025 by Landon Curt Noll.  All Rights Reserved.
+ * With -b size, the bitmap is split into blocks of size bits and the
+ * count of each block is written instead, in a single pass over the
+ * bitmap.  With -S step as well, size is a number of values of a bitmap
+ * with that step (i.e., size/step bits), and size must be a multiple of
+ * step.  The last block may be partial.  Block counts are written one
+ * per line, or with -r, as raw little-endian unsigned integers just wide
+ * enough (1, 2, 4 or 8 octets) to hold a count of size bits.
+ *
+ * With -w instead of -S, size is a number of values of a bitmap in the
+ * mod 30 wheel layout (see wheel.h), i.e., 8 bits per 30 values, and
+ * size must be a multiple of 30.
+ *
+ * With -m manifest, the shard files of a bitmap written by bitset -S
+ * (see manifest.h) are counted instead of stdin.  The manifest records
+ * the number of 1 bits of each shard, so a count of the whole bitmap is
+ * found without reading any shard.  With -b, a shard with no 1 bits, or
+ * with no 0 bits, is not read either, as its block counts follow from
+ * its length.  The other shards are read and counted in parallel, one
+ * thread per CPU, and the block counts are written in order.
+ *
+ * With -s, counters of bytes read, bits counted and values written, along
+ * with the wall clock and CPU time spent reading and counting, are written
+ * as JSON on stderr at exit.  The same report is written when SIGUSR1 is
+ * received.
+ *
+ * With -p, the CPU cycles, instructions, branch-misses and last level
+ * cache misses of the counting loop, along with cycles per bitmap octet
+ * and instructions per cycle, are written as JSON on stderr at exit.
+ * This requires Linux hardware performance counters.
+ *
+ * Copyright (c) 2001,2015,2023,2025,2026 by Landon Curt Noll.  All Rights Reserved.
  *
  * Permission to use, copy, modify, and distribute this software and
  * its documentation for any purpose and without fee is hereby granted,
@@ -41,11 +71,16 @@
 #include <string.h>
 #include <strings.h>
 
+#include "stats.h"
+#include "perfctr.h"
+#include "wheel.h"
+#include "manifest.h"
+
 
 /*
  * official version
  */
-#define VERSION "1.8.1 2025-04-08"          /* format: major.minor YYYY-MM-DD */
+#define VERSION "1.13.0 2026-10-19"          /* format: major.minor YYYY-MM-DD */
 
 /*
  * what we will count
@@ -60,10 +95,17 @@
  * usage message
  */
 static const char * const usage =
-  "usage: %s [-h] [-V] type\n"
+  "usage: %s [-h] [-V] [-s] [-p] [-m manifest] [-b size [-S step | -w] [-r]] type\n"
         "\n"
         "    -h            print help message and exit\n"
         "    -V            print version string and exit\n"
+        "    -s            write stats as JSON on stderr at exit and on SIGUSR1\n"
+        "    -p            write hardware counters of the main loop as JSON on stderr\n"
+        "    -m manifest   count the shards of this manifest instead of stdin\n"
+        "    -b size       write the count of each block of size bits\n"
+        "    -S step       -b size is in values of a bitmap with this step\n"
+        "    -w            -b size is in values of a mod 30 wheel bitmap\n"
+        "    -r            write block counts as raw little-endian integers\n"
         "\n"
 	"    type          0 ==> count 0 bits, 1 ==> count 1 bits, 2 ==> count bits\n"
         "\n"
@@ -89,48 +131,43 @@ static const char * const version = VERSION;
 static u_int8_t buffer[BUFSIZ];
 
 /*
- * popcnt - popcnt[x] number of 1 bits in 0 <= x < 256
+ * stats counters and phases, see -s
  */
-static const char popcnt[256] = {
-    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
-    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-    4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8
-};
+static unsigned long long bytes_read = 0;	/* bitmap octets read */
+static unsigned long long bits_counted = 0;	/* bits counted */
+static unsigned long long values_emitted = 0;	/* values written */
 
 /*
- * npopcnt - npopcnt[x] number of 0 bits in 0 <= x < 256
+ * block mode, see -b
  */
-static const char npopcnt[256] = {
-    8, 7, 7, 6, 7, 6, 6, 5, 7, 6, 6, 5, 6, 5, 5, 4,
-    7, 6, 6, 5, 6, 5, 5, 4, 6, 5, 5, 4, 5, 4, 4, 3,
-    7, 6, 6, 5, 6, 5, 5, 4, 6, 5, 5, 4, 5, 4, 4, 3,
-    6, 5, 5, 4, 5, 4, 4, 3, 5, 4, 4, 3, 4, 3, 3, 2,
-    7, 6, 6, 5, 6, 5, 5, 4, 6, 5, 5, 4, 5, 4, 4, 3,
-    6, 5, 5, 4, 5, 4, 4, 3, 5, 4, 4, 3, 4, 3, 3, 2,
-    6, 5, 5, 4, 5, 4, 4, 3, 5, 4, 4, 3, 4, 3, 3, 2,
-    5, 4, 4, 3, 4, 3, 3, 2, 4, 3, 3, 2, 3, 2, 2, 1,
-    7, 6, 6, 5, 6, 5, 5, 4, 6, 5, 5, 4, 5, 4, 4, 3,
-    6, 5, 5, 4, 5, 4, 4, 3, 5, 4, 4, 3, 4, 3, 3, 2,
-    6, 5, 5, 4, 5, 4, 4, 3, 5, 4, 4, 3, 4, 3, 3, 2,
-    5, 4, 4, 3, 4, 3, 3, 2, 4, 3, 3, 2, 3, 2, 2, 1,
-    6, 5, 5, 4, 5, 4, 4, 3, 5, 4, 4, 3, 4, 3, 3, 2,
-    5, 4, 4, 3, 4, 3, 3, 2, 4, 3, 3, 2, 3, 2, 2, 1,
-    5, 4, 4, 3, 4, 3, 3, 2, 4, 3, 3, 2, 3, 2, 2, 1,
-    4, 3, 3, 2, 3, 2, 2, 1, 3, 2, 2, 1, 2, 1, 1, 0
-};
+static unsigned long long blockbits = 0;	/* bits per block, 0 ==> no blocks */
+static int rawwidth = 0;			/* -r octets per count, 0 ==> text */
+
+/*
+ * manifest mode, see -m
+ *
+ * Each shard counts the part of each block that it holds.  A block may
+ * span the end of one shard and the start of the next.
+ */
+static struct manifest *man = NULL;	/* -m manifest, NULL ==> read stdin */
+static int man_type = COUNT_ONE;	/* what we will count in shards */
+static struct result {
+    unsigned long long first;	/* first block the shard holds bits of */
+    unsigned long nblock;	/* number of blocks the shard holds bits of */
+    unsigned long long *count;	/* count of each of those blocks */
+    unsigned long long octets;	/* octets of the shard read */
+} *result = NULL;			/* result of each shard */
+
+
+/*
+ * static functions
+ */
+static unsigned long count_ones(const u_int8_t *buf, unsigned long lo,
+				unsigned long hi);
+static void write_block(unsigned long long cnt);
+static unsigned long long count_manifest(int cnttype);
+static void count_shard(unsigned long i);
+static void emit_shard(unsigned long i);
 
 
 int
@@ -139,6 +176,19 @@ main(int argc, char *argv[])
     int cnttype;	    /* what we will count */
     int readcnt;	    /* chars read, or EOF */
     unsigned long bitcnt;   /* counted bits */
+    unsigned long ones;	    /* 1 bits counted in buffer or block part */
+    unsigned long long blockcnt;    /* counted bits in the current block */
+    unsigned long long blockleft;   /* bits left in the current block */
+    unsigned long long size = 0;    /* -b block size */
+    unsigned long long step = 0;    /* -S step, 0 ==> size is in bits */
+    unsigned long off;	    /* bit offset in buffer */
+    unsigned long nbits;    /* bits in buffer */
+    unsigned long m;	    /* bits of buffer in the current block */
+    int rflag = 0;	    /* 1 ==> -r */
+    int wflag = 0;	    /* 1 ==> -w */
+    char *mfile = NULL;	    /* -m manifest file, NULL ==> read stdin */
+    int read_phase;	    /* reading the bitmap */
+    int count_phase;	    /* counting bits */
     int i;
 
     /*
@@ -151,7 +201,7 @@ main(int argc, char *argv[])
     } else {
         ++prog;
     }
-    while ((i = getopt(argc, argv, ":hV")) != -1) {
+    while ((i = getopt(argc, argv, ":hVspb:S:rwm:")) != -1) {
 	switch (i) {
 
         case 'h':                   /* -h - print help message and exit */
@@ -164,6 +214,48 @@ main(int argc, char *argv[])
             exit(2); /* ooo */
             /*NOTREACHED*/
 
+	case 's':                   /* -s - write stats */
+	    stats_setup(prog);
+	    break;
+
+	case 'p':                   /* -p - write hardware counters */
+	    perfctr_setup(prog);
+	    break;
+
+	case 'b':                   /* -b size - count blocks of size */
+	    errno = 0;
+	    size = strtoull(optarg, NULL, 0);
+	    if (errno == ERANGE || size == 0 || optarg[0] == '-') {
+		fprintf(stderr, "%s: block size must be > 0: %s\n", program, optarg);
+		fprintf(stderr, usage, program, prog, version);
+		exit(3); /* ooo */
+		/*NOTREACHED*/
+	    }
+	    break;
+
+	case 'S':                   /* -S step - block size is in values */
+	    errno = 0;
+	    step = strtoull(optarg, NULL, 0);
+	    if (errno == ERANGE || step == 0 || optarg[0] == '-') {
+		fprintf(stderr, "%s: step value must be > 0: %s\n", program, optarg);
+		fprintf(stderr, usage, program, prog, version);
+		exit(3); /* ooo */
+		/*NOTREACHED*/
+	    }
+	    break;
+
+	case 'r':                   /* -r - write raw block counts */
+	    rflag = 1;
+	    break;
+
+	case 'w':                   /* -w - block size is in wheel values */
+	    wflag = 1;
+	    break;
+
+	case 'm':                   /* -m manifest - count shards */
+	    mfile = optarg;
+	    break;
+
 	case ':':
             (void) fprintf(stderr, "%s: ERROR: requires an argument -- %c\n", program, optopt);
 	    fprintf(stderr, usage, program, prog, version);
@@ -214,50 +306,182 @@ main(int argc, char *argv[])
     }
 
     /*
-     * read buffers until EOF
+     * determine the block size in bits
+     */
+    if (size == 0 && (step != 0 || rflag || wflag)) {
+	fprintf(stderr, "%s: -S, -w and -r require -b\n", program);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if (step != 0 && wflag) {
+	fprintf(stderr, "%s: -S and -w conflict\n", program);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    if (wflag) {
+	if (size % WHEEL_MOD != 0) {
+	    fprintf(stderr, "%s: block size: %llu must be a multiple of %d\n",
+		    program, size, WHEEL_MOD);
+	    fprintf(stderr, usage, program, prog, version);
+	    exit(3); /* ooo */
+	    /*NOTREACHED*/
+	}
+	blockbits = size / WHEEL_MOD * WHEEL_BITS;
+    } else if (step != 0) {
+	if (size % step != 0) {
+	    fprintf(stderr, "%s: block size: %llu must be a multiple of step: %llu\n",
+		    program, size, step);
+	    fprintf(stderr, usage, program, prog, version);
+	    exit(3); /* ooo */
+	    /*NOTREACHED*/
+	}
+	blockbits = size / step;
+    } else {
+	blockbits = size;
+    }
+    if (rflag) {
+	if (blockbits <= 0xff) {
+	    rawwidth = 1;
+	} else if (blockbits <= 0xffff) {
+	    rawwidth = 2;
+	} else if (blockbits <= 0xffffffff) {
+	    rawwidth = 4;
+	} else {
+	    rawwidth = 8;
+	}
+    }
+
+    /*
+     * with -m, count the shards instead of reading stdin
      */
     bitcnt = 0;
-    do {
+    if (mfile != NULL) {
+	man = manifest_read(prog, mfile);
+    }
+    blockcnt = 0;
+    blockleft = blockbits;
+    stats_counter("bytes_read", &bytes_read);
+    stats_counter("bits_counted", &bits_counted);
+    stats_counter("values_emitted", &values_emitted);
+    read_phase = stats_phase("read");
+    count_phase = stats_phase("count");
+    perfctr_start();
+    if (man != NULL) {
+	stats_switch(count_phase);
+	bitcnt = count_manifest(cnttype);
+	stats_bytes(count_phase, bytes_read);
+    }
+
+    /*
+     * read buffers until EOF
+     */
+    while (man == NULL && !feof(stdin)) {
 
 	/*
 	 * read a buffer
 	 */
+	if (stats_wanted) {
+	    stats_report(0);
+	}
+	stats_switch(read_phase);
 	clearerr(stdin);
 	readcnt = fread(buffer, 1, BUFSIZ, stdin);
-	if (readcnt == EOF) {
+	if (readcnt == EOF || (readcnt == 0 && feof(stdin))) {
 	    break;	/* EOF found */
 	} else if (readcnt <= 0 || ferror(stdin)) {
 	    fprintf(stderr, "%s: read error: %s\n", program, strerror(errno));
 	    exit(3);
 	}
+	bytes_read += readcnt;
+	stats_bytes(read_phase, readcnt);
+	stats_switch(count_phase);
+	stats_bytes(count_phase, readcnt);
+
+	nbits = (unsigned long)readcnt * OCTETBITS;
 
 	/*
 	 * count bits
 	 */
-	switch (cnttype) {
-	case COUNT_ZERO:
-	    for (i=0; i < readcnt; ++i) {
-		bitcnt += npopcnt[buffer[i]];
+	if (blockbits == 0) {
+	    switch (cnttype) {
+	    case COUNT_ZERO:
+		bitcnt += nbits - count_ones(buffer, 0, nbits);
+		break;
+	    case COUNT_ONE:
+		bitcnt += count_ones(buffer, 0, nbits);
+		break;
+	    case COUNT_ANY:
+		bitcnt += nbits;
+		break;
+	    default:
+		fprintf(stderr, "%s: invalid cnttype: %d\n", program, cnttype);
+		exit(4);
 	    }
-	    break;
-	case COUNT_ONE:
-	    for (i=0; i < readcnt; ++i) {
-		bitcnt += popcnt[buffer[i]];
+	    continue;
+	}
+
+	/*
+	 * count bits, block by block
+	 *
+	 * A block may begin or end part way into the buffer, and
+	 * may continue into the next buffer.
+	 */
+	for (off = 0; off < nbits; off += m) {
+	    m = nbits - off;
+	    if (m > blockleft) {
+		m = blockleft;
+	    }
+	    switch (cnttype) {
+	    case COUNT_ZERO:
+		ones = m - count_ones(buffer, off, off+m);
+		break;
+	    case COUNT_ONE:
+		ones = count_ones(buffer, off, off+m);
+		break;
+	    case COUNT_ANY:
+		ones = m;
+		break;
+	    default:
+		fprintf(stderr, "%s: invalid cnttype: %d\n", program, cnttype);
+		exit(4);
+	    }
+	    blockcnt += ones;
+	    bitcnt += ones;
+	    blockleft -= m;
+	    if (blockleft == 0) {
+		write_block(blockcnt);
+		blockcnt = 0;
+		blockleft = blockbits;
 	    }
-	    break;
-	case COUNT_ANY:
-	    bitcnt += readcnt*OCTETBITS;
-	    break;
-        default:
-	    fprintf(stderr, "%s: invalid cnttype: %d\n", program, cnttype);
-	    exit(4);
 	}
-    } while (!feof(stdin));
+    }
 
     /*
-     * report count
+     * report count, or the count of any final partial block
      */
-    printf("%ld\n", bitcnt);
+    if (blockbits == 0) {
+	printf("%ld\n", bitcnt);
+	++values_emitted;
+    } else if (blockleft < blockbits) {
+	write_block(blockcnt);
+    }
+    if (fflush(stdout) != 0) {
+	fprintf(stderr, "%s: write error: %s\n", program, strerror(errno));
+	exit(5);
+    }
+    perfctr_stop(bytes_read);
+    bits_counted = bitcnt;
+
+    /*
+     * report stats if -s
+     */
+    if (stats_on) {
+	fflush(stdout);
+	stats_switch(-1);
+	stats_report(1);
+    }
 
     /*
      * All done!
@@ -266,3 +490,316 @@ main(int argc, char *argv[])
      */
     exit(0);
 }
+
+
+/*
+ * count_ones - count the 1 bits in a range of bits of a buffer
+ *
+ * given:
+ *	buf	bitmap buffer
+ *	lo	bit offset of the first bit to count
+ *	hi	bit offset just beyond the last bit to count
+ *
+ * returns:
+ *	number of 1 bits in bits [lo, hi) of buf
+ *
+ * Whole octets are counted 64 bits at a time.  Partial octets at
+ * either edge are masked.
+ */
+static unsigned long
+count_ones(const u_int8_t *buf, unsigned long lo, unsigned long hi)
+{
+    unsigned long cnt = 0;		/* 1 bits counted */
+    unsigned long i = lo / OCTETBITS;	/* octet being counted */
+    unsigned long end = hi / OCTETBITS;	/* octet holding hi, if any */
+    u_int64_t word;			/* 64 bits of buf */
+
+    if (lo >= hi) {
+	return 0;
+    }
+
+    /*
+     * case: all bits are within a single octet
+     */
+    if (i == end) {
+	return __builtin_popcount(buf[i] & (0xff << (lo % OCTETBITS)) &
+				  ((1 << (hi % OCTETBITS)) - 1));
+    }
+
+    /*
+     * count a partial leading octet
+     */
+    if (lo % OCTETBITS != 0) {
+	cnt += __builtin_popcount(buf[i] & (0xff << (lo % OCTETBITS)));
+	++i;
+    }
+
+    /*
+     * count whole octets, 64 bits at a time
+     */
+    for (; i + sizeof(word) <= end; i += sizeof(word)) {
+	memcpy(&word, buf+i, sizeof(word));
+	cnt += __builtin_popcountll(word);
+    }
+    for (; i < end; ++i) {
+	cnt += __builtin_popcount(buf[i]);
+    }
+
+    /*
+     * count a partial trailing octet
+     */
+    if (hi % OCTETBITS != 0) {
+	cnt += __builtin_popcount(buf[end] & ((1 << (hi % OCTETBITS)) - 1));
+    }
+    return cnt;
+}
+
+
+/*
+ * write_block - write the count of a block
+ *
+ * given:
+ *	cnt	count of the block
+ */
+static void
+write_block(unsigned long long cnt)
+{
+    u_int8_t raw[sizeof(cnt)];	/* little-endian count */
+    int i;
+
+    clearerr(stdout);
+    if (rawwidth == 0) {
+	printf("%llu\n", cnt);
+    } else {
+	for (i=0; i < rawwidth; ++i) {
+	    raw[i] = (u_int8_t)(cnt >> (i*OCTETBITS));
+	}
+	fwrite(raw, 1, rawwidth, stdout);
+    }
+    if (ferror(stdout)) {
+	fprintf(stderr, "%s: write error: %s\n", program, strerror(errno));
+	exit(5);
+    }
+    ++values_emitted;
+    return;
+}
+
+
+/*
+ * count_manifest - count the bits of the shards of a manifest
+ *
+ * given:
+ *	cnttype	what we will count
+ *
+ * returns:
+ *	count of the whole bitmap
+ *
+ * Without -b, the count comes from the manifest alone.  With -b, the
+ * count of each block is written, including any final partial block.
+ */
+static unsigned long long
+count_manifest(int cnttype)
+{
+    unsigned long long cnt = 0;	/* count of the whole bitmap */
+    unsigned long long bits;	/* bits in a shard */
+    unsigned long i;
+
+    /*
+     * without blocks, the manifest counts answer for every shard
+     */
+    if (blockbits == 0) {
+	for (i=0; i < man->nshards; ++i) {
+	    bits = man->shard[i].octets * OCTETBITS;
+	    switch (cnttype) {
+	    case COUNT_ZERO:
+		cnt += bits - man->shard[i].count;
+		break;
+	    case COUNT_ONE:
+		cnt += man->shard[i].count;
+		break;
+	    case COUNT_ANY:
+		cnt += bits;
+		break;
+	    default:
+		fprintf(stderr, "%s: invalid cnttype: %d\n", program, cnttype);
+		exit(4);
+	    }
+	}
+	return cnt;
+    }
+
+    /*
+     * count blocks of the shards in parallel, and write them in order
+     */
+    man_type = cnttype;
+    result = calloc(man->nshards, sizeof(result[0]));
+    if (result == NULL) {
+	fprintf(stderr, "%s: cannot allocate shard results\n", program);
+	exit(8);
+    }
+    manifest_run(prog, man->nshards, count_shard, emit_shard);
+    for (i=0; i < man->nshards; ++i) {
+	bits = man->shard[i].octets * OCTETBITS;
+	cnt += (cnttype == COUNT_ANY) ? bits :
+	       (cnttype == COUNT_ONE) ? man->shard[i].count : bits - man->shard[i].count;
+    }
+
+    /*
+     * write the final partial block, if any
+     */
+    emit_shard(man->nshards);
+    return cnt;
+}
+
+
+/*
+ * count_shard - count the blocks of a shard
+ *
+ * given:
+ *	i	shard to count
+ *
+ * This is called from a shard thread, so it uses its own buffer and
+ * leaves stdout and the stats alone.  A shard with no 1 bits or no 0
+ * bits is not read, as its counts follow from its length.
+ */
+static void
+count_shard(unsigned long i)
+{
+    struct shard *s = &man->shard[i];	/* shard to count */
+    struct result *r = &result[i];	/* counts of the shard */
+    unsigned long long lo;	/* bitmap bit offset of the shard */
+    unsigned long long hi;	/* bitmap bit offset beyond the shard */
+    unsigned long long blo;	/* first bit of a block in the shard */
+    unsigned long long bhi;	/* bit beyond a block in the shard */
+    unsigned long long pos;	/* bitmap bit offset of the buffer */
+    unsigned long nbits;	/* bits in the buffer */
+    unsigned long off;		/* bit offset in the buffer */
+    unsigned long m;		/* bits of the buffer in the current block */
+    unsigned long ones;		/* 1 bits counted in a block part */
+    unsigned long b;		/* block of the shard */
+    u_int8_t *buf;		/* read buffer */
+    FILE *stream;		/* open shard file */
+    size_t readcnt;		/* octets read */
+
+    /*
+     * find the blocks that the shard holds bits of
+     */
+    lo = s->bit;
+    hi = s->bit + s->octets * OCTETBITS;
+    if (lo == hi) {
+	return;
+    }
+    r->first = lo / blockbits;
+    r->nblock = (hi-1) / blockbits - r->first + 1;
+    r->count = calloc(r->nblock, sizeof(r->count[0]));
+    if (r->count == NULL) {
+	fprintf(stderr, "%s: cannot allocate block counts\n", program);
+	exit(8);
+    }
+
+    /*
+     * a shard of all 0 or all 1 bits need not be read
+     */
+    if (man_type == COUNT_ANY || s->count == 0 || s->count == hi - lo) {
+	for (b=0; b < r->nblock; ++b) {
+	    blo = (r->first + b) * blockbits;
+	    bhi = blo + blockbits;
+	    blo = (blo < lo) ? lo : blo;
+	    bhi = (bhi > hi) ? hi : bhi;
+	    if (man_type == COUNT_ANY ||
+		(man_type == COUNT_ONE) == (s->count != 0)) {
+		r->count[b] = bhi - blo;
+	    }
+	}
+	return;
+    }
+
+    /*
+     * count the shard file, a buffer at a time
+     */
+    buf = malloc(BUFSIZ);
+    if (buf == NULL) {
+	fprintf(stderr, "%s: cannot allocate shard buffer\n", program);
+	exit(8);
+    }
+    stream = fopen(s->name, "r");
+    if (stream == NULL) {
+	fprintf(stderr, "%s: cannot open shard %s: %s\n", program, s->name, strerror(errno));
+	exit(6);
+    }
+    b = 0;
+    for (pos = lo; pos < hi; pos += nbits) {
+	readcnt = fread(buf, 1, BUFSIZ, stream);
+	if (readcnt == 0) {
+	    fprintf(stderr, "%s: shard %s is shorter than its manifest length\n",
+		    program, s->name);
+	    exit(6);
+	}
+	r->octets += readcnt;
+	nbits = readcnt * OCTETBITS;
+	if (nbits > hi - pos) {
+	    nbits = hi - pos;
+	}
+	for (off = 0; off < nbits; off += m) {
+	    m = (r->first + b + 1) * blockbits - (pos + off);
+	    if (m > nbits - off) {
+		m = nbits - off;
+	    }
+	    ones = count_ones(buf, off, off+m);
+	    r->count[b] += (man_type == COUNT_ONE) ? ones : m - ones;
+	    if ((pos + off + m) % blockbits == 0) {
+		++b;
+	    }
+	}
+    }
+    (void) fclose(stream);
+    free(buf);
+    return;
+}
+
+
+/*
+ * emit_shard - write the blocks of a shard that it completes
+ *
+ * given:
+ *	i	shard whose counts to write, man->nshards ==> end of bitmap
+ *
+ * This is called in shard order.  A block that continues into the next
+ * shard is held until that shard is emitted, and a final partial block
+ * is written at the end of the bitmap.
+ */
+static void
+emit_shard(unsigned long i)
+{
+    static unsigned long long held = 0;	/* count of a held block */
+    static int holding = 0;		/* 1 ==> a block is held */
+    struct result *r;			/* counts of the shard */
+    unsigned long long hi;		/* bitmap bit offset beyond the shard */
+    unsigned long b;
+
+    if (stats_wanted) {
+	stats_report(0);
+    }
+    if (i >= man->nshards) {
+	if (holding) {
+	    write_block(held);
+	}
+	return;
+    }
+    r = &result[i];
+    hi = man->shard[i].bit + man->shard[i].octets * OCTETBITS;
+    for (b=0; b < r->nblock; ++b) {
+	held += r->count[b];
+	if ((r->first + b + 1) * blockbits <= hi) {
+	    write_block(held);
+	    held = 0;
+	    holding = 0;
+	} else {
+	    holding = 1;
+	}
+    }
+    bytes_read += r->octets;
+    free(r->count);
+    r->count = NULL;
+    return;
+}
@@ -0,0 +1,770 @@
+/*
+ * rebase - convert a bitmap between start/step parameterizations
+ *
+ * We will read a bitmap with a given start and step from stdin and write
+ * the bitmap of the same set of values with a new start and new step to
+ * stdout.  See bitset for how a bitmap represents values.
+ *
+ * Either the new step must be a multiple of the old step, or the old step
+ * must be a multiple of the new step:
+ *
+ *	When newstep == k*step, the bitmap is compacted: every k-th bit
+ *	of the old bitmap is kept.  The difference between newstart and
+ *	start must be a multiple of step.
+ *
+ *	When step == k*newstep, the bitmap is expanded: each old bit is
+ *	followed by k-1 0 bits.  The difference between newstart and
+ *	start must be a multiple of newstep.
+ *
+ * For example, a step 1 bitmap starting at 1 is converted into an odd
+ * only prime bitmap with:
+ *
+ *	rebase 1 1 1 2 < all.bitmap > odd.bitmap
+ *
+ * and back with:
+ *
+ *	rebase 1 2 1 1 < odd.bitmap > all.bitmap
+ *
+ * Values below newstart are dropped.  Values in the new bitmap that are
+ * not in the old bitmap (below start, or not a multiple of the old step
+ * away from start) are 0.  As with bitset, the final octet written is the
+ * highest octet with a 1 bit.
+ *
+ * Bits are moved 64 at a time.  When compiled for a CPU with BMI2
+ * (e.g., with -march=native or -mbmi2), the PEXT and PDEP instructions
+ * are used to compact and expand words.  Otherwise a portable bit loop is
+ * used, with a fast shift and mask path for k == 2.  The bitmap is
+ * streamed, so it may be of any size.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <stdint.h>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+
+/*
+ * official version
+ */
+#define VERSION "1.0.0 2026-10-19"          /* format: major.minor YYYY-MM-DD */
+
+/*
+ * misc constants
+ */
+#define OCTETBITS (8)	/* 8 bits per octet */
+#define WORDBITS (64)	/* 64 bits per word */
+#define WORDOCTETS (8)	/* 8 octets per word */
+
+
+/*
+ * usage message
+ */
+static const char * const usage =
+  "usage: %s [-h] [-V] start step newstart newstep\n"
+        "\n"
+        "    -h            print help message and exit\n"
+        "    -V            print version string and exit\n"
+        "\n"
+        "    start         starting bitmap value of the input bitmap\n"
+        "    step          step values between bits of the input bitmap\n"
+        "    newstart      starting bitmap value of the output bitmap\n"
+        "    newstep       step values between bits of the output bitmap\n"
+        "\n"
+        "    NOTE: newstep must be a multiple of step, or step a multiple of newstep\n"
+        "\n"
+        "Exit codes:\n"
+        "    0         all OK\n"
+        "    2         -h and help string printed or -V and version string printed\n"
+        "    3         command line error\n"
+        " >= 10        internal error\n"
+        "\n"
+        "%s version: %s\n";
+
+
+/*
+ * static declarations
+ */
+static char *program = NULL;    /* our name */
+static char *prog = NULL;       /* basename of program */
+static const char * const version = VERSION;
+
+/*
+ * input buffer
+ */
+static u_int8_t ibuf[BUFSIZ];
+static int ilen = 0;		/* octets in ibuf */
+static int ipos = 0;		/* next octet of ibuf to use */
+static int ieof = 0;		/* 1 ==> EOF on stdin */
+
+/*
+ * output buffer and state
+ *
+ * Output bit opos is the next bit to be written.  Bits below opos that
+ * are not yet written are in acc (the current word), or are 0 octets that
+ * are held back in zeros, until we know a 1 bit follows them.
+ */
+static u_int8_t obuf[BUFSIZ];
+static int olen = 0;			/* octets in obuf */
+static u_int64_t acc = 0;		/* current output word */
+static unsigned long long opos = 0;	/* next output bit position */
+static unsigned long long zeros = 0;	/* held back 0 octets */
+static const u_int8_t zero[BUFSIZ];	/* 0 octets to write */
+
+
+/*
+ * static functions
+ */
+static long long parse_arg(const char *arg, const char *name);
+static int get_word(u_int64_t *word);
+static void put_octets(const u_int8_t *buf, int len);
+static void put_word(u_int64_t word);
+static void put_bits(u_int64_t bits, int n);
+static void put_zeros(unsigned long long n);
+static void put_end(void);
+static u_int64_t pext(u_int64_t v, u_int64_t mask);
+static u_int64_t pdep(u_int64_t v, u_int64_t mask);
+
+
+int
+main(int argc, char *argv[])
+{
+    long long start;		/* starting value of input bitmap */
+    long long step;		/* step of input bitmap */
+    long long newstart;		/* starting value of output bitmap */
+    long long newstep;		/* step of output bitmap */
+    long long k;		/* compaction or expansion factor */
+    long long o;		/* offset between input and output bit positions */
+    unsigned long long s;	/* input bits to skip */
+    u_int64_t word;		/* input word */
+    u_int64_t mask[WORDBITS];	/* mask[p] has bits p, p+k, ... < 64 */
+    int phase;			/* first selected bit of word, may be >= 64 */
+    int i;
+
+    /*
+     * parse args
+     */
+    program = argv[0];
+    prog = rindex(program, '/');
+    if (prog == NULL) {
+        prog = program;
+    } else {
+        ++prog;
+    }
+    while ((i = getopt(argc, argv, ":hV")) != -1) {
+	switch (i) {
+
+        case 'h':                   /* -h - print help message and exit */
+	    fprintf(stderr, usage, program, prog, version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case 'V':                   /* -V - print version string and exit */
+            (void) printf("%s\n", version);
+            exit(2); /* ooo */
+            /*NOTREACHED*/
+
+	case ':':
+            (void) fprintf(stderr, "%s: ERROR: requires an argument -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        case '?':
+            (void) fprintf(stderr, "%s: ERROR: illegal option -- %c\n", program, optopt);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+
+        default:
+            fprintf(stderr, "%s: ERROR: invalid -flag\n", program);
+	    fprintf(stderr, usage, program, prog, version);
+            exit(3); /* ooo */
+            /*NOTREACHED*/
+        }
+    }
+    /* skip over command line options */
+    argv += optind;
+    argc -= optind;
+    /* check the arg count */
+    if (argc != 4) {
+        fprintf(stderr, "%s: ERROR: expected 4 args, found: %d\n", program, argc);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    start = parse_arg(argv[0], "start");
+    step = parse_arg(argv[1], "step");
+    newstart = parse_arg(argv[2], "newstart");
+    newstep = parse_arg(argv[3], "newstep");
+    if (step <= 0 || newstep <= 0) {
+	fprintf(stderr, "%s: step and newstep must be > 0\n", program);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+
+    /*
+     * case: compact - keep every k-th input bit
+     *
+     * Output bit t' is input bit o + k*t'.  Output bits for which
+     * o + k*t' < 0 are 0, after which input bits s, s+k, s+2k, ...
+     * are kept.
+     */
+    if (newstep % step == 0) {
+	if ((newstart - start) % step != 0) {
+	    fprintf(stderr, "%s: newstart - start must be a multiple of step\n",
+		    program);
+	    exit(3); /* ooo */
+	    /*NOTREACHED*/
+	}
+	k = newstep / step;
+	o = (newstart - start) / step;
+	if (o < 0) {
+	    put_zeros((unsigned long long)((-o + k - 1) / k));
+	    s = (unsigned long long)(o + k * ((-o + k - 1) / k));
+	} else {
+	    s = (unsigned long long)o;
+	}
+
+	/*
+	 * skip input words before input bit s
+	 */
+	for (; s >= WORDBITS; s -= WORDBITS) {
+	    if (get_word(&word) == 0) {
+		break;
+	    }
+	}
+	if (s >= WORDBITS) {
+	    put_end();
+	    exit(0);
+	}
+
+	/*
+	 * form the selection masks
+	 */
+	if (k < WORDBITS) {
+	    for (phase=0; phase < k; ++phase) {
+		mask[phase] = 0;
+		for (i=phase; i < WORDBITS; i += (int)k) {
+		    mask[phase] |= (u_int64_t)1 << i;
+		}
+	    }
+	}
+
+	/*
+	 * compact each input word
+	 *
+	 * phase is the first bit of the word to keep.  The phase of the
+	 * next word is (phase - 64) mod k.  Only the 1st word can have a
+	 * phase >= k, in which case the bits below phase are not kept.
+	 */
+	phase = (int)s;
+	if (k < WORDBITS && phase >= k) {
+	    u_int64_t first;	/* bits of the 1st word to keep */
+
+	    first = mask[phase % k] & (~(u_int64_t)0 << phase);
+	    if (get_word(&word)) {
+		put_bits(pext(word, first), __builtin_popcountll(first));
+	    }
+	    phase = (int)(((phase - WORDBITS) % k + k) % k);
+	}
+	while (get_word(&word)) {
+	    if (k == 1) {
+		put_bits(word, WORDBITS);
+	    } else if (k < WORDBITS) {
+		if (word == 0) {
+		    put_zeros(__builtin_popcountll(mask[phase]));
+		} else if (k == 2) {
+		    put_bits(pext(word >> phase, mask[0]), WORDBITS/2);
+		} else {
+		    put_bits(pext(word, mask[phase]), __builtin_popcountll(mask[phase]));
+		}
+		phase = (int)((phase + k - WORDBITS % k) % k);
+	    } else {
+		if (phase < WORDBITS) {
+		    put_bits((word >> phase) & 1, 1);
+		    phase += (int)(k - WORDBITS);
+		} else {
+		    phase -= WORDBITS;
+		}
+	    }
+	}
+
+    /*
+     * case: expand - follow each input bit with k-1 0 bits
+     *
+     * Input bit t is output bit o + k*t.  Input bits for which
+     * o + k*t < 0 are dropped.
+     */
+    } else if (step % newstep == 0) {
+	unsigned long long base;	/* output bit of input word bit 0 */
+	int nb;				/* input bits left in word */
+	int q;				/* input bits to deposit at once */
+
+	if ((start - newstart) % newstep != 0) {
+	    fprintf(stderr, "%s: start - newstart must be a multiple of newstep\n",
+		    program);
+	    exit(3); /* ooo */
+	    /*NOTREACHED*/
+	}
+	k = step / newstep;
+	o = (start - newstart) / newstep;
+	if (o < 0) {
+	    s = (unsigned long long)((-o + k - 1) / k);
+	    put_zeros((unsigned long long)(o + k * (long long)s));
+	} else {
+	    s = 0;
+	    put_zeros((unsigned long long)o);
+	}
+
+	/*
+	 * skip input words before input bit s
+	 */
+	for (; s >= WORDBITS; s -= WORDBITS) {
+	    if (get_word(&word) == 0) {
+		break;
+	    }
+	}
+	if (s >= WORDBITS) {
+	    put_end();
+	    exit(0);
+	}
+
+	/*
+	 * form the deposit mask
+	 */
+	mask[0] = 0;
+	if (k < WORDBITS) {
+	    for (i=0; i < WORDBITS; i += (int)k) {
+		mask[0] |= (u_int64_t)1 << i;
+	    }
+	}
+
+	/*
+	 * expand each input word
+	 *
+	 * The first word starts at input bit s, the rest are whole words.
+	 */
+	while (get_word(&word)) {
+	    nb = WORDBITS - (int)s;
+	    word >>= s;
+	    s = 0;
+	    if (word == 0) {
+		put_zeros((unsigned long long)nb * k);
+	    } else if (k == 1) {
+		put_bits(word, nb);
+	    } else if (k < WORDBITS) {
+		q = WORDBITS / (int)k;
+		for (; nb > 0; nb -= q) {
+		    if (q > nb) {
+			q = nb;
+		    }
+		    put_bits(pdep(word & (((u_int64_t)1 << q) - 1), mask[0]), q * (int)k);
+		    word >>= q;
+		}
+	    } else {
+		base = opos;
+		while (word != 0) {
+		    i = __builtin_ctzll(word);
+		    word &= word - 1;
+		    put_zeros(base + (unsigned long long)k * i - opos);
+		    put_bits(1, 1);
+		}
+		put_zeros(base + (unsigned long long)k * nb - opos);
+	    }
+	}
+
+    } else {
+	fprintf(stderr, "%s: newstep must be a multiple of step, "
+			"or step a multiple of newstep\n", program);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+
+    /*
+     * write the final octets
+     */
+    put_end();
+
+    /*
+     * All done!
+     *
+     *	-- Jessica Noll, 1985
+     */
+    exit(0);
+}
+
+
+/*
+ * parse_arg - parse a signed long long command line arg
+ *
+ * given:
+ *	arg	command line arg
+ *	name	name of arg for error messages
+ *
+ * returns:
+ *	value of arg
+ */
+static long long
+parse_arg(const char *arg, const char *name)
+{
+    long long ret;	/* value of arg */
+    char *end;		/* just beyond the value */
+
+    errno = 0;
+    ret = strtoll(arg, &end, 0);
+    if (errno == ERANGE || end == arg || *end != '\0') {
+	fprintf(stderr, "%s: failed to parse %s value: %s\n", program, name, arg);
+	fprintf(stderr, usage, program, prog, version);
+        exit(3); /* ooo */
+        /*NOTREACHED*/
+    }
+    return ret;
+}
+
+
+/*
+ * get_word - get the next 64 bits of the input bitmap
+ *
+ * given:
+ *	word	where to put the next word, bit 0 is the lowest bit position
+ *
+ * returns:
+ *	1 ==> word was read, 0 ==> EOF
+ *
+ * A partial word at the end of the input is padded with 0 bits.
+ */
+static int
+get_word(u_int64_t *word)
+{
+    int n;	/* octets of word available */
+    int i;
+
+    /*
+     * refill the input buffer when it is empty
+     */
+    if (ipos >= ilen) {
+	if (ieof) {
+	    return 0;
+	}
+	clearerr(stdin);
+	ilen = fread(ibuf, 1, BUFSIZ, stdin);
+	ipos = 0;
+	if (ferror(stdin)) {
+	    fprintf(stderr, "%s: read error: %s\n", program, strerror(errno));
+	    exit(10);
+	}
+	if (ilen < BUFSIZ) {
+	    ieof = 1;
+	}
+	if (ilen <= 0) {
+	    return 0;
+	}
+    }
+
+    /*
+     * load the word in bitmap bit order
+     */
+    n = ilen - ipos;
+    if (n >= WORDOCTETS) {
+	memcpy(word, ibuf+ipos, WORDOCTETS);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	*word = __builtin_bswap64(*word);
+#endif
+	ipos += WORDOCTETS;
+    } else {
+	*word = 0;
+	for (i=0; i < n; ++i) {
+	    *word |= (u_int64_t)ibuf[ipos+i] << (i*OCTETBITS);
+	}
+	ipos = ilen;
+    }
+    return 1;
+}
+
+
+/*
+ * put_octets - buffer octets for output
+ *
+ * given:
+ *	buf	octets to write
+ *	len	number of octets
+ */
+static void
+put_octets(const u_int8_t *buf, int len)
+{
+    int n;	/* octets to copy into obuf */
+
+    while (len > 0) {
+	n = BUFSIZ - olen;
+	if (n > len) {
+	    n = len;
+	}
+	memcpy(obuf+olen, buf, n);
+	olen += n;
+	buf += n;
+	len -= n;
+	if (olen == BUFSIZ) {
+	    clearerr(stdout);
+	    if (fwrite(obuf, 1, BUFSIZ, stdout) != BUFSIZ) {
+		fprintf(stderr, "%s: write error: %s\n", program, strerror(errno));
+		exit(11);
+	    }
+	    olen = 0;
+	}
+    }
+    return;
+}
+
+
+/*
+ * put_word - write a complete output word
+ *
+ * given:
+ *	word	output word, bit 0 is the lowest bit position
+ *
+ * 0 octets, including those at the end of word, are held back until
+ * we know that a 1 bit follows them.
+ */
+static void
+put_word(u_int64_t word)
+{
+    u_int8_t octets[WORDOCTETS];	/* word in bitmap order */
+    unsigned long long n;		/* 0 octets to write */
+    int len;				/* octets up to the last non-0 octet */
+    int i;
+
+    if (word == 0) {
+	zeros += WORDOCTETS;
+	return;
+    }
+    for (i=0, len=0; i < WORDOCTETS; ++i) {
+	octets[i] = (u_int8_t)(word >> (i*OCTETBITS));
+	if (octets[i] != 0) {
+	    len = i+1;
+	}
+    }
+    for (; zeros > 0; zeros -= n) {
+	n = (zeros > BUFSIZ) ? BUFSIZ : zeros;
+	put_octets(zero, (int)n);
+    }
+    put_octets(octets, len);
+    zeros = WORDOCTETS - len;
+    return;
+}
+
+
+/*
+ * put_bits - append bits to the output bitmap
+ *
+ * given:
+ *	bits	bits to append, bit 0 first
+ *	n	number of bits to append, 0 < n <= 64, bits < 2^n
+ */
+static void
+put_bits(u_int64_t bits, int n)
+{
+    int used = (int)(opos % WORDBITS);	/* bits of acc in use */
+
+    acc |= bits << used;
+    if (used + n >= WORDBITS) {
+	put_word(acc);
+	acc = (used == 0) ? 0 : (bits >> (WORDBITS - used));
+    }
+    opos += n;
+    return;
+}
+
+
+/*
+ * put_zeros - append 0 bits to the output bitmap
+ *
+ * given:
+ *	n	number of 0 bits to append
+ */
+static void
+put_zeros(unsigned long long n)
+{
+    int used = (int)(opos % WORDBITS);	/* bits of acc in use */
+
+    if (used + n < WORDBITS) {
+	opos += n;
+	return;
+    }
+
+    /*
+     * complete the current word, then count whole 0 words
+     */
+    put_word(acc);
+    acc = 0;
+    n -= WORDBITS - used;
+    opos += WORDBITS - used;
+    zeros += (n / WORDBITS) * WORDOCTETS;
+    opos += n;
+    return;
+}
+
+
+/*
+ * put_end - write the final output octets
+ *
+ * Held back 0 octets are not written.
+ */
+static void
+put_end(void)
+{
+    /*
+     * write the current word, held back 0 octets are dropped
+     */
+    if (acc != 0) {
+	put_word(acc);
+	acc = 0;
+    }
+
+    /*
+     * flush the output buffer
+     */
+    clearerr(stdout);
+    if (olen > 0 && fwrite(obuf, 1, olen, stdout) != olen) {
+	fprintf(stderr, "%s: write error: %s\n", program, strerror(errno));
+	exit(11);
+    }
+    if (fflush(stdout) != 0) {
+	fprintf(stderr, "%s: write error: %s\n", program, strerror(errno));
+	exit(11);
+    }
+    return;
+}
+
+
+/*
+ * pext - gather the bits of v selected by mask into the low bits
+ *
+ * given:
+ *	v	value to gather bits from
+ *	mask	bits of v to gather
+ *
+ * returns:
+ *	selected bits of v, lowest selected bit in bit 0
+ */
+static u_int64_t
+pext(u_int64_t v, u_int64_t mask)
+{
+#if defined(__BMI2__)
+    return _pext_u64(v, mask);
+#else
+    u_int64_t ret = 0;	/* gathered bits */
+    u_int64_t low;	/* lowest remaining bit of mask */
+    int i;
+
+    /*
+     * fast path: every other bit
+     */
+    if (mask == 0x5555555555555555ULL) {
+	v &= 0x5555555555555555ULL;
+	v = (v | (v >> 1)) & 0x3333333333333333ULL;
+	v = (v | (v >> 2)) & 0x0f0f0f0f0f0f0f0fULL;
+	v = (v | (v >> 4)) & 0x00ff00ff00ff00ffULL;
+	v = (v | (v >> 8)) & 0x0000ffff0000ffffULL;
+	v = (v | (v >> 16)) & 0x00000000ffffffffULL;
+	return v;
+    }
+
+    /*
+     * one bit of mask at a time
+     */
+    for (i=0; mask != 0; ++i) {
+	low = mask & -mask;
+	if (v & low) {
+	    ret |= (u_int64_t)1 << i;
+	}
+	mask ^= low;
+    }
+    return ret;
+#endif
+}
+
+
+/*
+ * pdep - scatter the low bits of v into the bits selected by mask
+ *
+ * given:
+ *	v	value to scatter bits from
+ *	mask	where to scatter bits to
+ *
+ * returns:
+ *	low bits of v in the bits of mask, lowest bit of v in the lowest bit
+ */
+static u_int64_t
+pdep(u_int64_t v, u_int64_t mask)
+{
+#if defined(__BMI2__)
+    return _pdep_u64(v, mask);
+#else
+    u_int64_t ret = 0;	/* scattered bits */
+    u_int64_t low;	/* lowest remaining bit of mask */
+    int i;
+
+    /*
+     * fast path: every other bit
+     */
+    if (mask == 0x5555555555555555ULL) {
+	v &= 0x00000000ffffffffULL;
+	v = (v | (v << 16)) & 0x0000ffff0000ffffULL;
+	v = (v | (v << 8)) & 0x00ff00ff00ff00ffULL;
+	v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	v = (v | (v << 2)) & 0x3333333333333333ULL;
+	v = (v | (v << 1)) & 0x5555555555555555ULL;
+	return v;
+    }
+
+    /*
+     * one bit of mask at a time
+     */
+    for (i=0; mask != 0; ++i) {
+	low = mask & -mask;
+	if (v & ((u_int64_t)1 << i)) {
+	    ret |= low;
+	}
+	mask ^= low;
+    }
+    return ret;
+#endif
+}
@@ -0,0 +1,327 @@
+/*
+ * stats - runtime statistics and phase timing
+ *
+ * A tool registers its counters and phases, switches between phases as
+ * it runs, and reports everything as a single line of JSON on stderr
+ * when it exits or when it receives a SIGUSR1.
+ *
+ * The report looks like:
+ *
+ *	{"program":"popcnt","final":true,
+ *	 "counters":{"bytes_read":8192,...},
+ *	 "phases":{"read":{"wall_sec":0.000012,"cpu_sec":0.000011,
+ *			   "bytes":8192,"mb_per_sec":682.666667},...},
+ *	 "total":{"wall_sec":0.000105,"cpu_sec":0.000101}}
+ *
+ * all on a single line.  Phases are exclusive: time spent in one phase
+ * is not counted in any other phase.  Time before the first phase switch
+ * is only counted in the total.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+
+#include "stats.h"
+
+
+/*
+ * stats state
+ */
+int stats_on = 0;			/* 1 ==> stats_setup() was called */
+volatile sig_atomic_t stats_wanted = 0;	/* 1 ==> SIGUSR1 received */
+
+/*
+ * registered counters
+ */
+static struct counter {
+    const char *name;			/* JSON name of counter */
+    unsigned long long *value;		/* tool's counter */
+} counter[STATS_MAXCOUNTER];
+static int counters = 0;		/* registered counters */
+
+/*
+ * registered phases
+ */
+static struct phase {
+    const char *name;			/* JSON name of phase */
+    double wall;			/* wall clock seconds in phase */
+    double cpu;				/* CPU seconds in phase */
+    unsigned long long bytes;		/* bytes processed in phase */
+} phase[STATS_MAXPHASE];
+static int phases = 0;			/* registered phases */
+
+static const char *report_name = NULL;	/* program name to report */
+static int current = -1;		/* current phase, -1 ==> none */
+static struct timespec wall_begin;	/* wall clock at stats_setup() */
+static struct timespec cpu_begin;	/* CPU clock at stats_setup() */
+static struct timespec wall_mark;	/* wall clock at last switch */
+static struct timespec cpu_mark;	/* CPU clock at last switch */
+
+
+/*
+ * static functions
+ */
+static void catch_usr1(int sig);
+static double elapsed(const struct timespec *from, const struct timespec *to);
+static void charge(struct timespec *wall_now, struct timespec *cpu_now);
+
+
+/*
+ * stats_setup - enable stats and start the clocks
+ *
+ * given:
+ *	prog	program name to report
+ *
+ * SIGUSR1 is caught so that stats_wanted is set.  The tool should call
+ * stats_report(0) when it notices stats_wanted.
+ */
+void
+stats_setup(const char *prog)
+{
+    struct sigaction sa;	/* SIGUSR1 action */
+
+    report_name = prog;
+    stats_on = 1;
+    clock_gettime(CLOCK_MONOTONIC, &wall_begin);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_begin);
+    wall_mark = wall_begin;
+    cpu_mark = cpu_begin;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = catch_usr1;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    if (sigaction(SIGUSR1, &sa, NULL) < 0) {
+	perror("sigaction");
+	exit(11);
+    }
+    return;
+}
+
+
+/*
+ * stats_counter - register a counter to report
+ *
+ * given:
+ *	name	JSON name of counter
+ *	value	pointer to the tool's counter
+ */
+void
+stats_counter(const char *name, unsigned long long *value)
+{
+    if (counters >= STATS_MAXCOUNTER) {
+	fprintf(stderr, "stats: FATAL: too many counters: %s\n", name);
+	exit(12);
+    }
+    counter[counters].name = name;
+    counter[counters].value = value;
+    ++counters;
+    return;
+}
+
+
+/*
+ * stats_phase - register a phase to time
+ *
+ * given:
+ *	name	JSON name of phase
+ *
+ * returns:
+ *	phase id to give to stats_switch() and stats_bytes()
+ */
+int
+stats_phase(const char *name)
+{
+    if (phases >= STATS_MAXPHASE) {
+	fprintf(stderr, "stats: FATAL: too many phases: %s\n", name);
+	exit(13);
+    }
+    phase[phases].name = name;
+    phase[phases].wall = 0.0;
+    phase[phases].cpu = 0.0;
+    phase[phases].bytes = 0;
+    return phases++;
+}
+
+
+/*
+ * stats_switch - charge time to the current phase and enter a new phase
+ *
+ * given:
+ *	id	phase id to enter, or -1 ==> no phase
+ */
+void
+stats_switch(int id)
+{
+    struct timespec wall_now;	/* wall clock now */
+    struct timespec cpu_now;	/* CPU clock now */
+
+    if (stats_on == 0 || id == current) {
+	return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &wall_now);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_now);
+    charge(&wall_now, &cpu_now);
+    current = id;
+    return;
+}
+
+
+/*
+ * stats_bytes - note bytes processed by a phase
+ *
+ * given:
+ *	id	phase id
+ *	bytes	bytes processed
+ */
+void
+stats_bytes(int id, unsigned long long bytes)
+{
+    if (stats_on == 0 || id < 0 || id >= phases) {
+	return;
+    }
+    phase[id].bytes += bytes;
+    return;
+}
+
+
+/*
+ * stats_report - write counters and phase times as JSON on stderr
+ *
+ * given:
+ *	final	1 ==> final report at exit, 0 ==> SIGUSR1 snapshot
+ */
+void
+stats_report(int final)
+{
+    struct timespec wall_now;	/* wall clock now */
+    struct timespec cpu_now;	/* CPU clock now */
+    const char *p;
+    int i;
+
+    stats_wanted = 0;
+    if (stats_on == 0) {
+	return;
+    }
+
+    /*
+     * bring the current phase up to date
+     */
+    clock_gettime(CLOCK_MONOTONIC, &wall_now);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_now);
+    charge(&wall_now, &cpu_now);
+
+    /*
+     * program name, quoting any JSON special chars
+     */
+    fputs("{\"program\":\"", stderr);
+    for (p = report_name; p != NULL && *p != '\0'; ++p) {
+	if (*p == '"' || *p == '\\') {
+	    putc('\\', stderr);
+	}
+	putc(*p, stderr);
+    }
+    fprintf(stderr, "\",\"final\":%s", final ? "true" : "false");
+
+    /*
+     * counters
+     */
+    fputs(",\"counters\":{", stderr);
+    for (i=0; i < counters; ++i) {
+	fprintf(stderr, "%s\"%s\":%llu", (i > 0 ? "," : ""),
+		counter[i].name, *counter[i].value);
+    }
+
+    /*
+     * phases
+     */
+    fputs("},\"phases\":{", stderr);
+    for (i=0; i < phases; ++i) {
+	fprintf(stderr, "%s\"%s\":{\"wall_sec\":%.6f,\"cpu_sec\":%.6f,"
+			"\"bytes\":%llu,\"mb_per_sec\":%.6f}",
+		(i > 0 ? "," : ""), phase[i].name, phase[i].wall, phase[i].cpu,
+		phase[i].bytes,
+		(phase[i].wall > 0.0 ? phase[i].bytes / phase[i].wall / 1e6 : 0.0));
+    }
+
+    /*
+     * total
+     */
+    fprintf(stderr, "},\"total\":{\"wall_sec\":%.6f,\"cpu_sec\":%.6f}}\n",
+	    elapsed(&wall_begin, &wall_now), elapsed(&cpu_begin, &cpu_now));
+    fflush(stderr);
+    return;
+}
+
+
+/*
+ * catch_usr1 - note that a stats report was requested
+ */
+static void
+catch_usr1(int sig)
+{
+    stats_wanted = 1;
+    return;
+}
+
+
+/*
+ * elapsed - seconds between two clock values
+ */
+static double
+elapsed(const struct timespec *from, const struct timespec *to)
+{
+    return (double)(to->tv_sec - from->tv_sec) +
+	   (double)(to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+
+/*
+ * charge - charge time since the last mark to the current phase
+ *
+ * given:
+ *	wall_now	wall clock now, becomes the new mark
+ *	cpu_now		CPU clock now, becomes the new mark
+ */
+static void
+charge(struct timespec *wall_now, struct timespec *cpu_now)
+{
+    if (current >= 0) {
+	phase[current].wall += elapsed(&wall_mark, wall_now);
+	phase[current].cpu += elapsed(&cpu_mark, cpu_now);
+    }
+    wall_mark = *wall_now;
+    cpu_mark = *cpu_now;
+    return;
+}
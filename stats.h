@@ -0,0 +1,72 @@
+/*
+ * stats - runtime statistics and phase timing
+ *
+ * A tool registers its counters and phases, switches between phases as
+ * it runs, and reports everything as a single line of JSON on stderr
+ * when it exits or when it receives a SIGUSR1.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#if !defined(INCLUDE_STATS_H)
+#define INCLUDE_STATS_H
+
+#include <signal.h>
+
+
+/*
+ * limits
+ */
+#define STATS_MAXCOUNTER (16)	/* max registered counters */
+#define STATS_MAXPHASE (4)	/* max registered phases */
+
+
+/*
+ * stats state
+ *
+ * stats_on is 0 unless stats_setup() was called; until then the stats
+ * functions below do nothing.  stats_wanted is set by SIGUSR1 and is
+ * cleared by stats_report().
+ */
+extern int stats_on;
+extern volatile sig_atomic_t stats_wanted;
+
+
+/*
+ * external functions
+ */
+extern void stats_setup(const char *prog);
+extern void stats_counter(const char *name, unsigned long long *value);
+extern int stats_phase(const char *name);
+extern void stats_switch(int phase);
+extern void stats_bytes(int phase, unsigned long long bytes);
+extern void stats_report(int final);
+
+
+#endif /* INCLUDE_STATS_H */
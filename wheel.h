@@ -0,0 +1,113 @@
+/*
+ * wheel - mod 30 wheel bitmap layout
+ *
+ * In the mod 30 wheel layout, octet 'x' of a bitmap holds the 8 values
+ * from start + 30*x to start + 30*x + 29 that are not a multiple of 2, 3
+ * or 5.  The bit value from octet 'x' and bit 'y', i.e.,:
+ *
+ *	(octet[x] & (1<<y))
+ *
+ * represents the value:
+ *
+ *	start + 30*x + wheel_residue[y]
+ *
+ * where start is a multiple of 30.  The value 'v', is represented by
+ * octet 'x' bit 'y':
+ *
+ *	x = (v - start) / 30
+ *	y = wheel_bit[(v - start) % 30]
+ *
+ * provided that wheel_bit[(v - start) % 30] >= 0.  (i.e., the value is
+ * not a multiple of 2, 3 or 5).  Values that are a multiple of 2, 3 or
+ * 5 cannot be represented, so 2, 3 and 5 are not in a wheel prime bitmap.
+ *
+ * Consecutive values that can be represented have consecutive bit
+ * positions, so runs of values are runs of bits, just as they are in
+ * the start + step*(8*x + y) layout.  A wheel bitmap is 8/15 the size
+ * of an odd only (step 2) bitmap.
+ *
+ * Copyright (c) 2026 by Landon Curt Noll.  All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and
+ * its documentation for any purpose and without fee is hereby granted,
+ * provided that the above copyright, this permission notice and text
+ * this comment, and the disclaimer below appear in all of the following:
+ *
+ *       supporting documentation
+ *       source copies
+ *       source works derived from this source
+ *       binaries derived from this source or from derived source
+ *
+ * LANDON CURT NOLL DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO
+ * EVENT SHALL LANDON CURT NOLL BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF
+ * USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * chongo (Landon Curt Noll) /\oo/\
+ *
+ * http://www.isthe.com/chongo/index.html
+ * https://github.com/lcn2
+ *
+ * Share and enjoy!  :-)
+ */
+
+
+#if !defined(INCLUDE_WHEEL_H)
+#define INCLUDE_WHEEL_H
+
+
+/*
+ * wheel size
+ */
+#define WHEEL_MOD (30)		/* values per wheel octet */
+#define WHEEL_BITS (8)		/* values not a multiple of 2, 3, 5 per octet */
+
+
+/*
+ * wheel_residue - wheel_residue[y] is the value of bit y less 30*x
+ */
+static const int wheel_residue[WHEEL_BITS] = {
+    1, 7, 11, 13, 17, 19, 23, 29
+};
+
+/*
+ * wheel_bit - wheel_bit[r] is the bit holding residue r, or -1 ==> none
+ */
+static const int wheel_bit[WHEEL_MOD] = {
+    -1,  0, -1, -1, -1, -1, -1,  1, -1, -1, -1,  2, -1,  3, -1,
+    -1, -1,  4, -1,  5, -1, -1, -1,  6, -1, -1, -1, -1, -1,  7
+};
+
+/*
+ * wheel_below - wheel_below[r] is the number of bits for residues < r
+ *
+ * This is also the bit of the lowest value >= r that can be represented.
+ */
+static const int wheel_below[WHEEL_MOD] = {
+     0,  0,  1,  1,  1,  1,  1,  1,  2,  2,  2,  2,  3,  3,  4,
+     4,  4,  4,  5,  5,  6,  6,  6,  6,  7,  7,  7,  7,  7,  7
+};
+
+/*
+ * wheel_up - wheel_up[r] is the distance from r up to the next residue >= r
+ */
+static const int wheel_up[WHEEL_MOD] = {
+     1,  0,  5,  4,  3,  2,  1,  0,  3,  2,  1,  0,  1,  0,  3,
+     2,  1,  0,  1,  0,  3,  2,  1,  0,  5,  4,  3,  2,  1,  0
+};
+
+/*
+ * wheel_down - wheel_down[r] is the distance from r down to the next residue <= r
+ *
+ * NOTE: wheel_down[0] is 1 because 29 of the previous octet is just below 0.
+ */
+static const int wheel_down[WHEEL_MOD] = {
+     1,  0,  1,  2,  3,  4,  5,  0,  1,  2,  3,  0,  1,  0,  1,
+     2,  3,  0,  1,  0,  1,  2,  3,  0,  1,  2,  3,  4,  5,  0
+};
+
+
+#endif /* INCLUDE_WHEEL_H */